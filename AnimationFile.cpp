@@ -0,0 +1,172 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Play an animation that was converted into bit planes ahead of time.
+
+#include "AnimationFile.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+void AnimationFile::initHeader(Header *header)
+{
+  memset(header, 0, sizeof(Header));
+  memcpy(header->magic, "RGBM", 4);
+
+  header->version = Version;
+  header->pwmBits = RgbMatrix::PwmBits;
+  header->width = RgbMatrix::Width;
+  header->height = RgbMatrix::Height;
+  header->rowsPerSubPanel = RgbMatrix::RowsPerSubPanel;
+  header->columnCnt = RgbMatrix::ColumnCnt;
+  header->frameSize = sizeof(RgbMatrix::Frame);
+}
+
+
+AnimationFile::AnimationFile(RgbMatrix *matrix)
+  : _matrix(matrix), _data(NULL), _size(0), _header(NULL), _table(NULL)
+{
+}
+
+
+AnimationFile::~AnimationFile()
+{
+  close();
+}
+
+
+bool AnimationFile::open(const char *filename)
+{
+  close();
+
+  const int fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+  {
+    perror(filename);
+    return false;
+  }
+
+  struct stat st;
+
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(Header))
+  {
+    fprintf(stderr, "%s: Not an animation file.\n", filename);
+    ::close(fd);
+    return false;
+  }
+
+  void *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if (data == MAP_FAILED)
+  {
+    perror(filename);
+    return false;
+  }
+
+  _data = data;
+  _size = st.st_size;
+
+  const Header *header = (const Header *)_data;
+
+#define EXIT_WITH_MSG(m) { fprintf(stderr, "%s: %s\n", filename, m); \
+     close(); return false; }
+
+  if (memcmp(header->magic, "RGBM", 4) != 0)
+    EXIT_WITH_MSG("Not an animation file.");
+
+  Header expected;
+  initHeader(&expected);
+
+  if (header->version != Version)
+    EXIT_WITH_MSG("Unsupported version.");
+
+  if (header->pwmBits != expected.pwmBits ||
+      header->width != expected.width ||
+      header->height != expected.height ||
+      header->rowsPerSubPanel != expected.rowsPerSubPanel ||
+      header->columnCnt != expected.columnCnt ||
+      header->frameSize != expected.frameSize)
+    EXIT_WITH_MSG("Made for a different matrix.");
+
+  if (header->frameCount == 0)
+    EXIT_WITH_MSG("No frames.");
+
+  const uint64_t tableSize = (uint64_t)header->frameCount * sizeof(FrameEntry);
+
+  if (header->tableOffset % sizeof(uint64_t) != 0 ||
+      header->tableOffset > _size || tableSize > _size - header->tableOffset)
+    EXIT_WITH_MSG("Frame table is outside of the file.");
+
+  const FrameEntry *table =
+    (const FrameEntry *)((const uint8_t *)_data + header->tableOffset);
+
+  // Check every frame now, so playing never has to.
+  for (uint32_t i = 0; i < header->frameCount; i++)
+  {
+    if (table[i].offset % 16 != 0 || table[i].offset > _size ||
+        header->frameSize > _size - table[i].offset)
+      EXIT_WITH_MSG("Frame is outside of the file.");
+  }
+
+#undef EXIT_WITH_MSG
+
+  _header = header;
+  _table = table;
+
+  // Frames are mostly played in order.
+  madvise(_data, _size, MADV_SEQUENTIAL);
+
+  return true;
+}
+
+
+void AnimationFile::close()
+{
+  // Don't unmap a frame the matrix may still be showing, or scanning in a
+  // refresh that started before it was hidden.
+  if (_header)
+  {
+    hide();
+    _matrix->waitForRefresh();
+  }
+
+  if (_data) munmap(_data, _size);
+
+  _data = NULL;
+  _size = 0;
+  _header = NULL;
+  _table = NULL;
+}
+
+
+const RgbMatrix::Frame *AnimationFile::frame(int i) const
+{
+  return (const RgbMatrix::Frame *)((const uint8_t *)_data + _table[i].offset);
+}
+
+
+void AnimationFile::show(int i)
+{
+  _matrix->showFrame(frame(i));
+
+  // Page in the next frame while this one is shown.
+  const int next = (i + 1) % frameCount();
+  const long pageSize = sysconf(_SC_PAGESIZE);
+  const uintptr_t start = (uintptr_t)frame(next) & ~(uintptr_t)(pageSize - 1);
+
+  madvise((void *)start, (uintptr_t)frame(next) + _header->frameSize - start,
+          MADV_WILLNEED);
+}
+
+
+void AnimationFile::hide()
+{
+  _matrix->showFrame(NULL);
+}
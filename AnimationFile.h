@@ -0,0 +1,97 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Play an animation that was converted into bit planes ahead of time.
+//
+// The file is memory mapped, and the matrix scans out the frames straight
+// from the mapping, so playing even hours of animation takes no decoding,
+// no color conversion and no copying. Use AnimationWriter (or the
+// animation-convert tool) to make the files.
+//
+// File layout (in the byte order of the Pi):
+//
+//   Header
+//   Frames     : RgbMatrix::Frame each, at 16 byte aligned offsets
+//   FrameEntry : one per frame, at header.tableOffset
+//
+// The frames hold raw GPIO bits, so a file only plays on a matrix built with
+// the same geometry (checked when it is opened) and pin mapping.
+
+#ifndef RPI_ANIMATIONFILE_H
+#define RPI_ANIMATIONFILE_H
+
+#include "RgbMatrix.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+class AnimationFile
+{
+public:
+
+  static const uint16_t Version = 1;
+
+  struct Header {
+    char magic[4];              // "RGBM"
+    uint16_t version;
+    uint16_t pwmBits;
+    uint16_t width;
+    uint16_t height;
+    uint16_t rowsPerSubPanel;
+    uint16_t columnCnt;
+    uint32_t frameSize;         // sizeof(RgbMatrix::Frame)
+    uint32_t frameCount;
+    uint64_t tableOffset;
+  };
+
+  struct FrameEntry {
+    uint64_t offset;            // From the start of the file
+    uint32_t delayMs;
+    uint32_t reserved;
+  };
+
+  // Fill in a header for frames of this build of RgbMatrix.
+  static void initHeader(Header *header);
+
+
+  AnimationFile(RgbMatrix *matrix);
+  ~AnimationFile();
+
+  // Map an animation file. Fails if it was made for a different matrix.
+  bool open(const char *filename);
+
+  // Stop showing the animation and unmap the file.
+  void close();
+
+  inline int frameCount() const { return _header ? _header->frameCount : 0; }
+
+  // How long frame i should be shown, in milliseconds.
+  inline int delayMs(int i) const { return _table[i].delayMs; }
+
+  // Frame i, inside the mapping.
+  const RgbMatrix::Frame *frame(int i) const;
+
+  // Show frame i on the matrix, and ask the kernel to read ahead the next.
+  void show(int i);
+
+  // Show what is drawn on the matrix again.
+  void hide();
+
+
+private:
+
+  AnimationFile(const AnimationFile &);
+  AnimationFile &operator=(const AnimationFile &);
+
+  RgbMatrix *const _matrix;
+
+  void *_data;
+  size_t _size;
+
+  const Header *_header;
+  const FrameEntry *_table;
+};
+
+#endif
@@ -0,0 +1,121 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Write an animation file one frame at a time.
+
+#include "AnimationWriter.h"
+
+#include <string.h>
+
+
+AnimationWriter::AnimationWriter(const RgbMatrix *matrix)
+  : _matrix(matrix), _file(NULL), _offset(0), _ok(false),
+    _frame(new RgbMatrix::Frame)
+{
+}
+
+
+AnimationWriter::~AnimationWriter()
+{
+  close();
+  delete _frame;
+}
+
+
+bool AnimationWriter::open(const char *filename)
+{
+  close();
+
+  _file = fopen(filename, "wb");
+  if (_file == NULL)
+  {
+    perror(filename);
+    return false;
+  }
+
+  // The header is written again with the frame count when closing.
+  AnimationFile::Header header;
+  AnimationFile::initHeader(&header);
+
+  _ok = fwrite(&header, sizeof(header), 1, _file) == 1;
+  _offset = sizeof(header);
+  _table.clear();
+
+  return _ok;
+}
+
+
+bool AnimationWriter::addFrame(const Canvas &canvas, int delayMs,
+                               int16_t x, int16_t y)
+{
+  _matrix->convertFrame(canvas, _frame, x, y);
+  return addFrame(*_frame, delayMs);
+}
+
+
+bool AnimationWriter::addFrame(const RgbMatrix::Frame &frame, int delayMs)
+{
+  if (_file == NULL || !pad(16)) return false;
+
+  AnimationFile::FrameEntry entry;
+  entry.offset = _offset;
+  entry.delayMs = delayMs;
+  entry.reserved = 0;
+
+  if (fwrite(&frame, sizeof(frame), 1, _file) != 1)
+  {
+    _ok = false;
+    return false;
+  }
+
+  _offset += sizeof(frame);
+  _table.push_back(entry);
+
+  return true;
+}
+
+
+bool AnimationWriter::close()
+{
+  if (_file == NULL) return false;
+
+  AnimationFile::Header header;
+  AnimationFile::initHeader(&header);
+
+  pad(sizeof(uint64_t));
+
+  header.frameCount = _table.size();
+  header.tableOffset = _offset;
+
+  if (!_table.empty() &&
+      fwrite(&_table[0], sizeof(AnimationFile::FrameEntry), _table.size(), _file) != _table.size())
+    _ok = false;
+
+  if (fseek(_file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, _file) != 1)
+    _ok = false;
+
+  if (fclose(_file) != 0) _ok = false;
+
+  _file = NULL;
+  _table.clear();
+
+  return _ok;
+}
+
+
+bool AnimationWriter::pad(size_t align)
+{
+  static const char zeros[16] = { 0 };
+
+  const size_t padding = (align - _offset % align) % align;
+
+  if (padding && fwrite(zeros, 1, padding, _file) != padding)
+  {
+    _ok = false;
+    return false;
+  }
+
+  _offset += padding;
+  return _ok;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Write an animation file (see AnimationFile.h) one frame at a time.
+//
+// Frames are converted into bit planes as they are added and written out
+// straight away, so long animations can be converted without keeping them
+// in memory. The matrix only converts frames; it can be made without GPIO
+// (RgbMatrix(NULL)) when preparing files on another machine.
+
+#ifndef RPI_ANIMATIONWRITER_H
+#define RPI_ANIMATIONWRITER_H
+
+#include "AnimationFile.h"
+#include "Canvas.h"
+#include "RgbMatrix.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+
+class AnimationWriter
+{
+public:
+
+  AnimationWriter(const RgbMatrix *matrix);
+  ~AnimationWriter();
+
+  bool open(const char *filename);
+
+  // Convert a canvas with its top left at (x, y) and add it as a frame.
+  bool addFrame(const Canvas &canvas, int delayMs, int16_t x = 0, int16_t y = 0);
+
+  // Add a frame that is already converted.
+  bool addFrame(const RgbMatrix::Frame &frame, int delayMs);
+
+  inline int frameCount() const { return _table.size(); }
+
+  // Write the frame table and header. Returns false if any write failed.
+  bool close();
+
+
+private:
+
+  AnimationWriter(const AnimationWriter &);
+  AnimationWriter &operator=(const AnimationWriter &);
+
+  // Pad the file with zeros up to a multiple of align.
+  bool pad(size_t align);
+
+  const RgbMatrix *const _matrix;
+
+  FILE *_file;
+  uint64_t _offset;
+  bool _ok;
+
+  std::vector<AnimationFile::FrameEntry> _table;
+  RgbMatrix::Frame *_frame;  // Buffer for converting canvases
+};
+
+#endif
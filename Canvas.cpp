@@ -0,0 +1,145 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// An offscreen RGB image with the same drawing functions as the RGB Matrix.
+
+#include "Canvas.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+// Read the next header token of a PPM file, skipping comments.
+static bool readPpmValue(FILE *f, int *value)
+{
+  int c = fgetc(f);
+
+  while (c == '#' || c == ' ' || c == '\t' || c == '\r' || c == '\n')
+  {
+    if (c == '#')
+    {
+      while (c != '\n' && c != EOF) c = fgetc(f);
+    }
+
+    c = fgetc(f);
+  }
+
+  if (c == EOF) return false;
+
+  ungetc(c, f);
+
+  return fscanf(f, "%d", value) == 1;
+}
+
+
+Canvas::Canvas(int16_t width, int16_t height) : Graphics(width, height)
+{
+  _pixels = new Color[width * height];
+  clear();
+}
+
+
+Canvas::~Canvas()
+{
+  delete [] _pixels;
+}
+
+
+Canvas *Canvas::loadPpm(const char *filename)
+{
+  FILE *f = fopen(filename, "rb");
+  if (f == NULL)
+  {
+    perror(filename);
+    return NULL;
+  }
+
+#define EXIT_WITH_MSG(m) { fprintf(stderr, "%s: %s\n", filename, m); \
+     fclose(f); return NULL; }
+
+  char magic[2];
+  int width, height, maxval;
+
+  if (fread(magic, 1, 2, f) != 2 || magic[0] != 'P' || magic[1] != '6')
+    EXIT_WITH_MSG("Can only handle P6 as PPM type.");
+
+  if (!readPpmValue(f, &width) || !readPpmValue(f, &height) ||
+      width <= 0 || height <= 0 || width > 4096 || height > 4096)
+    EXIT_WITH_MSG("Width/height expected.");
+
+  if (!readPpmValue(f, &maxval) || maxval != 255)
+    EXIT_WITH_MSG("Only 255 for maxval allowed.");
+
+  fgetc(f);  // the single whitespace before the pixels
+
+  Canvas *canvas = new Canvas(width, height);
+  const size_t pixelCount = width * height;
+
+  if (fread(canvas->_pixels, sizeof(Color), pixelCount, f) != pixelCount)
+  {
+    delete canvas;
+    EXIT_WITH_MSG("Not enough pixels read.");
+  }
+
+#undef EXIT_WITH_MSG
+
+  fclose(f);
+  return canvas;
+}
+
+
+bool Canvas::savePpm(const char *filename) const
+{
+  FILE *f = fopen(filename, "wb");
+  if (f == NULL)
+  {
+    perror(filename);
+    return false;
+  }
+
+  const size_t pixelCount = _width * _height;
+
+  fprintf(f, "P6\n%d %d\n255\n", _width, _height);
+
+  if (fwrite(_pixels, sizeof(Color), pixelCount, f) != pixelCount)
+  {
+    perror(filename);
+    fclose(f);
+    return false;
+  }
+
+  if (fclose(f) != 0)
+  {
+    perror(filename);
+    return false;
+  }
+
+  return true;
+}
+
+
+void Canvas::drawPixel(int16_t x, int16_t y, Color color)
+{
+  if (isClipped(x, y)) return;
+
+  _pixels[y * _width + x] = color;
+}
+
+
+void Canvas::blendPixel(int16_t x, int16_t y, Color color, uint8_t alpha)
+{
+  if (alpha == 0 || isClipped(x, y)) return;
+
+  Color &p = _pixels[y * _width + x];
+
+  p.red = div255(color.red * alpha + p.red * (255 - alpha));
+  p.green = div255(color.green * alpha + p.green * (255 - alpha));
+  p.blue = div255(color.blue * alpha + p.blue * (255 - alpha));
+}
+
+
+void Canvas::clear()
+{
+  memset(_pixels, 0, _width * _height * sizeof(Color));
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// An offscreen RGB image (24 bits per pixel) with the same drawing functions
+// as the RGB Matrix.
+//
+// Compose sprites and widgets on a Canvas, then copy it onto the matrix with
+// RgbMatrix::blit(), which converts whole rows into the bit planes at once.
+
+#ifndef RPI_CANVAS_H
+#define RPI_CANVAS_H
+
+#include "Graphics.h"
+
+#include <stdint.h>
+
+
+class Canvas : public Graphics
+{
+public:
+
+  // All pixels start out black.
+  Canvas(int16_t width, int16_t height);
+  ~Canvas();
+
+  // Load a binary PPM (P6) image with a maxval of 255.
+  // Returns NULL if the file can't be read.
+  static Canvas *loadPpm(const char *filename);
+
+  // Save as a binary PPM (P6) image. Returns false if the file can't be
+  // written.
+  bool savePpm(const char *filename) const;
+
+  void drawPixel(int16_t x, int16_t y, Color color);
+
+  // Blends with the color already at (x, y).
+  void blendPixel(int16_t x, int16_t y, Color color, uint8_t alpha);
+
+  // Set all pixels to black.
+  void clear();
+
+  inline Color getPixel(int16_t x, int16_t y) const
+  {
+    return _pixels[y * _width + x];
+  }
+
+  // The pixels of row y, left to right.
+  inline Color *row(int16_t y) { return &_pixels[y * _width]; }
+  inline const Color *row(int16_t y) const { return &_pixels[y * _width]; }
+
+
+private:
+
+  // Not copyable.
+  Canvas(const Canvas &);
+  Canvas &operator=(const Canvas &);
+
+  Color *_pixels;
+};
+
+#endif
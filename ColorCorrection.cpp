@@ -0,0 +1,113 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Color calibration for one panel, compiled into lookup tables.
+
+#include "ColorCorrection.h"
+
+#include <math.h>
+#include <string.h>
+
+
+ColorCorrection::ColorCorrection()
+{
+  reset();
+}
+
+
+void ColorCorrection::reset()
+{
+  const float identity[9] = { 1, 0, 0,
+                              0, 1, 0,
+                              0, 0, 1 };
+
+  for (int c = 0; c < 3; c++)
+  {
+    for (int v = 0; v < 256; v++)
+    {
+      _curve[c][v] = v;
+    }
+  }
+
+  setMatrix(identity);
+}
+
+
+void ColorCorrection::setMatrix(const float matrix[9])
+{
+  for (int i = 0; i < 9; i++)
+  {
+    float m = matrix[i];
+
+    if (m < -8) m = -8;
+    if (m > 8) m = 8;
+
+    _matrix[i] = m;
+  }
+
+  compile();
+}
+
+
+void ColorCorrection::setWhiteBalance(float red, float green, float blue)
+{
+  const float matrix[9] = { red, 0, 0,
+                            0, green, 0,
+                            0, 0, blue };
+
+  setMatrix(matrix);
+}
+
+
+void ColorCorrection::setCurve(Channel channel, const uint8_t curve[256])
+{
+  memcpy(_curve[channel], curve, 256);
+  compile();
+}
+
+
+void ColorCorrection::setGamma(float gamma)
+{
+  for (int v = 0; v < 256; v++)
+  {
+    const uint8_t out = (uint8_t)(255 * pow(v / 255.0, gamma) + 0.5);
+
+    _curve[Red][v] = _curve[Green][v] = _curve[Blue][v] = out;
+  }
+
+  compile();
+}
+
+
+void ColorCorrection::compile()
+{
+  // Products with 8 bit values stay within int16 in 1/16ths.
+  for (int in = 0; in < 3; in++)
+  {
+    for (int v = 0; v < 256; v++)
+    {
+      for (int out = 0; out < 3; out++)
+      {
+        const float m = _matrix[out * 3 + in];
+
+        _table[in][v][out] = (int16_t)floor(m * v * (1 << FractionBits) + 0.5);
+      }
+    }
+  }
+
+  _identity = true;
+
+  for (int i = 0; i < 9; i++)
+  {
+    if (_matrix[i] != ((i % 4 == 0) ? 1 : 0)) _identity = false;
+  }
+
+  for (int c = 0; c < 3; c++)
+  {
+    for (int v = 0; v < 256; v++)
+    {
+      if (_curve[c][v] != v) _identity = false;
+    }
+  }
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Color calibration for one panel: a 3x3 matrix that mixes the red, green
+// and blue of a color (white balance, or matching the primaries of another
+// batch of panels), followed by a response curve for each channel.
+//
+// Both are compiled into lookup tables whenever they're set, so correcting a
+// color is nine table lookups and three adds. RgbMatrix applies the
+// correction of each chained board when colors are converted into the bit
+// planes, so it costs nothing while the display refreshes.
+
+#ifndef RPI_COLORCORRECTION_H
+#define RPI_COLORCORRECTION_H
+
+#include "Graphics.h"
+
+#include <stdint.h>
+
+
+class ColorCorrection
+{
+public:
+
+  enum Channel { Red, Green, Blue };
+
+  // No correction.
+  ColorCorrection();
+
+  // Row-major 3x3 matrix: output red is row 0 times (red, green, blue), and
+  // so on. Entries are limited to -8 .. 8.
+  void setMatrix(const float matrix[9]);
+
+  // Scale each channel (a diagonal matrix), e.g. 1.0, 0.85, 0.9 for panels
+  // that show white too green and blue.
+  void setWhiteBalance(float red, float green, float blue);
+
+  // Response curve of a channel, applied after the matrix.
+  void setCurve(Channel channel, const uint8_t curve[256]);
+
+  // Set the curves of all channels to 255 * (value / 255) ^ gamma.
+  void setGamma(float gamma);
+
+  // Back to no correction.
+  void reset();
+
+  inline bool isIdentity() const { return _identity; }
+
+  inline Color apply(Color color) const
+  {
+    const int16_t *r = _table[0][color.red];
+    const int16_t *g = _table[1][color.green];
+    const int16_t *b = _table[2][color.blue];
+
+    Color out;
+    out.red   = _curve[Red][clamp(r[0] + g[0] + b[0])];
+    out.green = _curve[Green][clamp(r[1] + g[1] + b[1])];
+    out.blue  = _curve[Blue][clamp(r[2] + g[2] + b[2])];
+
+    return out;
+  }
+
+
+private:
+
+  // Matrix products are in 1/16ths.
+  static const int FractionBits = 4;
+
+  static inline uint8_t clamp(int sum)
+  {
+    sum = (sum + (1 << (FractionBits - 1))) >> FractionBits;
+    return (sum < 0) ? 0 : (sum > 255) ? 255 : sum;
+  }
+
+  // Rebuild the tables from the matrix.
+  void compile();
+
+  float _matrix[9];
+  bool _identity;
+
+  // _table[input channel][value][output channel]: the product of the value
+  // with the matrix entry of that input and output channel. Laid out so the
+  // three products of one input value are next to each other.
+  int16_t _table[3][256][3];
+
+  uint8_t _curve[3][256];
+};
+
+#endif
@@ -0,0 +1,201 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Convert HSV, HSL and CIE L*a*b* colors to RGB with precomputed tables.
+
+#include "ColorSpace.h"
+
+#include <math.h>
+
+
+// Entries of the sRGB transfer curve table, over linear 0 to 1.
+static const int SrgbSteps = 4096;
+
+struct ColorTables {
+  Color hue[ColorSpace::HueSteps];  // Fully saturated color of each hue
+  uint8_t srgb[SrgbSteps];          // Linear intensity to 8 bit sRGB
+
+  ColorTables()
+  {
+    for (int h = 0; h < ColorSpace::HueSteps; h++)
+    {
+      const uint8_t lo = h & 255;  // Primary/secondary color mix
+      Color &c = hue[h];
+
+      // Sextant of the color wheel
+      switch (h >> 8)
+      {
+        case 0 : c.red = 255;      c.green = lo;       c.blue = 0;        break; // R to Y
+        case 1 : c.red = 255 - lo; c.green = 255;      c.blue = 0;        break; // Y to G
+        case 2 : c.red = 0;        c.green = 255;      c.blue = lo;       break; // G to C
+        case 3 : c.red = 0;        c.green = 255 - lo; c.blue = 255;      break; // C to B
+        case 4 : c.red = lo;       c.green = 0;        c.blue = 255;      break; // B to M
+        default: c.red = 255;      c.green = 0;        c.blue = 255 - lo; break; // M to R
+      }
+    }
+
+    for (int i = 0; i < SrgbSteps; i++)
+    {
+      const double v = (double)i / (SrgbSteps - 1);
+      const double s = (v <= 0.0031308) ? 12.92 * v
+                                        : 1.055 * pow(v, 1 / 2.4) - 0.055;
+
+      srgb[i] = (uint8_t)(s * 255 + 0.5);
+    }
+  }
+};
+
+
+static const ColorTables &tables()
+{
+  static const ColorTables t;
+  return t;
+}
+
+
+static inline uint16_t wrapHue(long hue)
+{
+  hue %= ColorSpace::HueSteps;
+  if (hue < 0) hue += ColorSpace::HueSteps;
+
+  return hue;
+}
+
+
+// Same arithmetic as Graphics::colorHSV(): saturation and value plus one,
+// so the products can be shifted rather than divided.
+static inline Color hsvFromBase(Color base, uint8_t sat, uint8_t val)
+{
+  const uint16_t s1 = sat + 1;
+  const uint16_t v1 = val + 1;
+
+  const uint8_t r = 255 - (((255 - base.red)   * s1) >> 8);
+  const uint8_t g = 255 - (((255 - base.green) * s1) >> 8);
+  const uint8_t b = 255 - (((255 - base.blue)  * s1) >> 8);
+
+  Color c;
+  c.red   = (r * v1) >> 8;
+  c.green = (g * v1) >> 8;
+  c.blue  = (b * v1) >> 8;
+
+  return c;
+}
+
+
+static inline uint8_t hslChannel(uint8_t base, int chroma, int low)
+{
+  // low + base * chroma / 255, dividing by 255 as a multiply and shift.
+  const int v = low + ((base * chroma * 257 + 32768) >> 16);
+
+  return (v > 255) ? 255 : v;
+}
+
+
+static inline Color hslFromBase(Color base, uint8_t sat, uint8_t light)
+{
+  // The chroma is largest at middle lightness, and the lowest channel is
+  // as far below the lightness as the highest is above it.
+  const int distance = 2 * light - 255;
+  const int chroma = ((255 - (distance < 0 ? -distance : distance)) *
+                      (sat + 1)) >> 8;
+  const int low = light - chroma / 2;
+
+  Color c;
+  c.red   = hslChannel(base.red, chroma, low);
+  c.green = hslChannel(base.green, chroma, low);
+  c.blue  = hslChannel(base.blue, chroma, low);
+
+  return c;
+}
+
+
+static inline float labInverse(float t)
+{
+  const float Delta = 6.0f / 29.0f;
+
+  return (t > Delta) ? t * t * t : 3 * Delta * Delta * (t - 4.0f / 29.0f);
+}
+
+
+static inline uint8_t encodeSrgb(const uint8_t *srgb, float v)
+{
+  if (v <= 0) return srgb[0];
+  if (v >= 1) return srgb[SrgbSteps - 1];
+
+  return srgb[(int)(v * (SrgbSteps - 1) + 0.5f)];
+}
+
+
+static inline Color labToRgb(const uint8_t *srgb, float l, float a, float b)
+{
+  const float fy = (l + 16) / 116;
+  const float fx = fy + a / 500;
+  const float fz = fy - b / 200;
+
+  // XYZ relative to the D65 white point.
+  const float x = 0.95047f * labInverse(fx);
+  const float y = labInverse(fy);
+  const float z = 1.08883f * labInverse(fz);
+
+  Color c;
+  c.red   = encodeSrgb(srgb,  3.2406f * x - 1.5372f * y - 0.4986f * z);
+  c.green = encodeSrgb(srgb, -0.9689f * x + 1.8758f * y + 0.0415f * z);
+  c.blue  = encodeSrgb(srgb,  0.0557f * x - 0.2040f * y + 1.0570f * z);
+
+  return c;
+}
+
+
+Color ColorSpace::hsv(long hue, uint8_t sat, uint8_t val)
+{
+  return hsvFromBase(tables().hue[wrapHue(hue)], sat, val);
+}
+
+
+void ColorSpace::hsv(const uint16_t *hue, const uint8_t *sat,
+                     const uint8_t *val, Color *out, int count)
+{
+  const Color *base = tables().hue;
+
+  for (int i = 0; i < count; i++)
+  {
+    out[i] = hsvFromBase(base[hue[i] % HueSteps], sat[i], val[i]);
+  }
+}
+
+
+Color ColorSpace::hsl(long hue, uint8_t sat, uint8_t light)
+{
+  return hslFromBase(tables().hue[wrapHue(hue)], sat, light);
+}
+
+
+void ColorSpace::hsl(const uint16_t *hue, const uint8_t *sat,
+                     const uint8_t *light, Color *out, int count)
+{
+  const Color *base = tables().hue;
+
+  for (int i = 0; i < count; i++)
+  {
+    out[i] = hslFromBase(base[hue[i] % HueSteps], sat[i], light[i]);
+  }
+}
+
+
+Color ColorSpace::lab(float l, float a, float b)
+{
+  return labToRgb(tables().srgb, l, a, b);
+}
+
+
+void ColorSpace::lab(const float *l, const float *a, const float *b,
+                     Color *out, int count)
+{
+  const uint8_t *srgb = tables().srgb;
+
+  for (int i = 0; i < count; i++)
+  {
+    out[i] = labToRgb(srgb, l[i], a[i], b[i]);
+  }
+}
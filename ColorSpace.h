@@ -0,0 +1,51 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Convert HSV, HSL and CIE L*a*b* colors to RGB, one at a time or a row at
+// a time.
+//
+// Hues are in 1536ths of the color wheel (256 steps between each primary
+// and secondary color), the same as Graphics::colorHSV(). The fully
+// saturated color of every hue, and the sRGB transfer curve for Lab, are
+// precomputed tables, so converting a row of colors is table lookups and
+// small integer multiplies; effects like plasma and rainbows can convert
+// every pixel of every frame.
+
+#ifndef RPI_COLORSPACE_H
+#define RPI_COLORSPACE_H
+
+#include "Graphics.h"
+
+#include <stdint.h>
+
+
+class ColorSpace
+{
+public:
+
+  // Hues in a full turn of the color wheel.
+  static const int HueSteps = 1536;
+
+  static Color hsv(long hue, uint8_t sat, uint8_t val);
+
+  // Convert count colors from separate hue, saturation and value arrays.
+  static void hsv(const uint16_t *hue, const uint8_t *sat, const uint8_t *val,
+                  Color *out, int count);
+
+  // Lightness 0 is black, 255 white, and about 128 the pure color at full
+  // saturation.
+  static Color hsl(long hue, uint8_t sat, uint8_t light);
+
+  static void hsl(const uint16_t *hue, const uint8_t *sat,
+                  const uint8_t *light, Color *out, int count);
+
+  // CIE L*a*b* (D65 white): L 0 to 100, a and b about -128 to 127.
+  // Colors outside of sRGB are clipped.
+  static Color lab(float l, float a, float b);
+
+  static void lab(const float *l, const float *a, const float *b,
+                  Color *out, int count);
+};
+
+#endif
@@ -0,0 +1,141 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Combine a stack of Canvas layers into the frame shown on the RGB Matrix.
+
+#include "Compositor.h"
+
+
+Compositor::Compositor(RgbMatrix *m) : _matrix(m)
+{
+  Color black = { 0, 0, 0 };
+  _background = black;
+}
+
+
+int Compositor::addLayer(Canvas *canvas, BlendMode mode, uint8_t opacity)
+{
+  Layer l;
+  l.canvas = canvas;
+  l.x = 0;
+  l.y = 0;
+  l.opacity = opacity;
+  l.mode = mode;
+  l.visible = true;
+  l.keyed = false;
+  l.colorKey = _background;
+
+  _layers.push_back(l);
+
+  return _layers.size() - 1;
+}
+
+
+void Compositor::setBackground(Color color)
+{
+  _background = color;
+}
+
+
+void Compositor::composite()
+{
+  const int Width = RgbMatrix::Width;
+  Color line[Width];
+
+  for (int y = 0; y < RgbMatrix::Height; y++)
+  {
+    for (int x = 0; x < Width; x++)
+    {
+      line[x] = _background;
+    }
+
+    for (size_t i = 0; i < _layers.size(); i++)
+    {
+      const Layer &l = _layers[i];
+      const Canvas &canvas = *l.canvas;
+
+      if (!l.visible || l.opacity == 0) continue;
+      if (y < l.y || y >= l.y + canvas.height()) continue;
+
+      // Columns of the layer that are on the display.
+      const int left = (l.x < 0) ? 0 : l.x;
+      const int right = (l.x + canvas.width() > Width) ? Width : (l.x + canvas.width());
+      if (left >= right) continue;
+
+      blend(&line[left], canvas.row(y - l.y) + (left - l.x), right - left, l);
+    }
+
+    _matrix->writeRow(0, y, line, Width);
+  }
+}
+
+
+// The blend loops work on the color bytes of the whole span, which lets the
+// compiler vectorize them. Transparent pixels are restored afterwards.
+void Compositor::blend(Color *dst, const Color *src, int n,
+                       const Layer &layer) const
+{
+  Color saved[RgbMatrix::Width];
+
+  if (layer.keyed)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      saved[i] = dst[i];
+    }
+  }
+
+  uint8_t *d = (uint8_t *)dst;
+  const uint8_t *s = (const uint8_t *)src;
+  const int bytes = n * sizeof(Color);
+  const uint16_t a = layer.opacity;
+
+  switch (layer.mode)
+  {
+    case BlendAdd:
+      for (int i = 0; i < bytes; i++)
+      {
+        const uint16_t sum = d[i] + div255(s[i] * a);
+        d[i] = (sum > 255) ? 255 : sum;
+      }
+      break;
+
+    case BlendMultiply:
+      for (int i = 0; i < bytes; i++)
+      {
+        const uint8_t product = div255(d[i] * s[i]);
+        d[i] = d[i] - div255((d[i] - product) * a);
+      }
+      break;
+
+    case BlendScreen:
+      for (int i = 0; i < bytes; i++)
+      {
+        const uint8_t screen = 255 - div255((255 - d[i]) * (255 - s[i]));
+        d[i] = d[i] + div255((screen - d[i]) * a);
+      }
+      break;
+
+    default: // BlendNormal
+      for (int i = 0; i < bytes; i++)
+      {
+        d[i] = div255(s[i] * a + d[i] * (255 - a));
+      }
+      break;
+  }
+
+  if (layer.keyed)
+  {
+    const Color &key = layer.colorKey;
+
+    for (int i = 0; i < n; i++)
+    {
+      if (src[i].red == key.red && src[i].green == key.green &&
+          src[i].blue == key.blue)
+      {
+        dst[i] = saved[i];
+      }
+    }
+  }
+}
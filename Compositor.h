@@ -0,0 +1,74 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Combine a stack of Canvas layers (e.g. background, widgets, overlay) into
+// the frame shown on the RGB Matrix.
+//
+// Each layer has a position, an opacity, a blend mode and an optional
+// transparent color. composite() blends the layers bottom to top one display
+// row at a time and converts each finished row into the bit planes, so there
+// is no full-size intermediate image.
+
+#ifndef RPI_COMPOSITOR_H
+#define RPI_COMPOSITOR_H
+
+#include "Canvas.h"
+#include "RgbMatrix.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+
+class Compositor
+{
+public:
+
+  enum BlendMode {
+    BlendNormal,    // The layer covers what is below it
+    BlendAdd,       // Lighten: sum of both, clipped to white
+    BlendMultiply,  // Darken: product of both
+    BlendScreen     // Lighten: inverse of the product of the inverses
+  };
+
+  struct Layer {
+    Canvas *canvas;
+    int16_t x;          // Position of the canvas on the display
+    int16_t y;
+    uint8_t opacity;    // 0 (invisible) - 255 (opaque)
+    BlendMode mode;
+    bool visible;
+    bool keyed;         // If true, pixels of colorKey color are transparent
+    Color colorKey;
+  };
+
+
+  Compositor(RgbMatrix *m);
+
+  // Put a canvas on top of the stack of layers. Returns the index of the
+  // layer, which is used to change it later. The canvas is not copied.
+  int addLayer(Canvas *canvas, BlendMode mode = BlendNormal,
+               uint8_t opacity = 255);
+
+  inline Layer &layer(int index) { return _layers[index]; }
+  inline int layerCount() const { return _layers.size(); }
+
+  // Color below all layers.
+  void setBackground(Color color);
+
+  // Blend all visible layers and convert the result into the bit planes.
+  void composite();
+
+
+private:
+
+  // Blend n pixels of a layer onto a row of the frame.
+  void blend(Color *dst, const Color *src, int n, const Layer &layer) const;
+
+  RgbMatrix *const _matrix;
+  std::vector<Layer> _layers;
+  Color _background;
+};
+
+#endif
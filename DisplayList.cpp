@@ -0,0 +1,490 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A recorded sequence of drawing calls, cached as sprites on the matrix.
+
+#include "DisplayList.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+
+DisplayList::DisplayList()
+  : _frame(NULL), _frameColors(NULL), _frameMatrix(NULL), _frameValid(false)
+{
+}
+
+
+DisplayList::~DisplayList()
+{
+  clear();
+  delete _frame;
+  delete _frameColors;
+}
+
+
+int DisplayList::add(Shape shape, Color color, int16_t a0, int16_t a1,
+                     int16_t a2, int16_t a3, int16_t a4, int16_t a5)
+{
+  Item item;
+  item.shape = shape;
+  item.args[0] = a0;
+  item.args[1] = a1;
+  item.args[2] = a2;
+  item.args[3] = a3;
+  item.args[4] = a4;
+  item.args[5] = a5;
+  item.color = color;
+  item.font = NULL;
+  item.align = Graphics::AlignLeft;
+  item.visible = true;
+
+  Cache cache;
+  cache.sprite = NULL;
+  cache.key = item;
+  cache.key.font = NULL;
+  cache.key.shape = ShapeText;  // Never matches a new item, see rasterize()
+  cache.key.visible = false;
+  cache.x = 0;
+  cache.y = 0;
+  cache.whole = false;
+  cache.shown = false;
+
+  _items.push_back(item);
+  _caches.push_back(cache);
+
+  return _items.size() - 1;
+}
+
+
+int DisplayList::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                          Color color)
+{
+  return add(ShapeLine, color, x0, y0, x1, y1);
+}
+
+
+int DisplayList::drawRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                          Color color)
+{
+  return add(ShapeRect, color, x, y, w, h);
+}
+
+
+int DisplayList::fillRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                          Color color)
+{
+  return add(ShapeFillRect, color, x, y, w, h);
+}
+
+
+int DisplayList::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                               int16_t r, Color color)
+{
+  return add(ShapeRoundRect, color, x, y, w, h, r);
+}
+
+
+int DisplayList::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                               int16_t r, Color color)
+{
+  return add(ShapeFillRoundRect, color, x, y, w, h, r);
+}
+
+
+int DisplayList::drawCircle(int16_t x, int16_t y, int16_t r, Color color)
+{
+  return add(ShapeCircle, color, x, y, r);
+}
+
+
+int DisplayList::fillCircle(int16_t x, int16_t y, int16_t r, Color color)
+{
+  return add(ShapeFillCircle, color, x, y, r);
+}
+
+
+int DisplayList::drawTriangle(int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+                              int16_t x3, int16_t y3, Color color)
+{
+  return add(ShapeTriangle, color, x1, y1, x2, y2, x3, y3);
+}
+
+
+int DisplayList::fillTriangle(int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+                              int16_t x3, int16_t y3, Color color)
+{
+  return add(ShapeFillTriangle, color, x1, y1, x2, y2, x3, y3);
+}
+
+
+int DisplayList::drawText(int16_t x, int16_t y, const char *text,
+                          const Font &font, Color color,
+                          Graphics::TextAlign align)
+{
+  const int index = add(ShapeText, color, x, y, 0);
+
+  _items[index].text = text;
+  _items[index].font = &font;
+  _items[index].align = align;
+
+  return index;
+}
+
+
+int DisplayList::putChar(int16_t x, int16_t y, unsigned char c, uint8_t size,
+                         Color color)
+{
+  const char text[2] = { (char)c, 0 };
+
+  return drawText(x, y, text, Font::builtIn(size), color);
+}
+
+
+void DisplayList::clear()
+{
+  for (size_t i = 0; i < _caches.size(); i++)
+  {
+    delete _caches[i].sprite;
+  }
+
+  _items.clear();
+  _caches.clear();
+  _frameValid = false;
+}
+
+
+// Draw an item on g, moved by (dx, dy).
+static void drawItem(Graphics &g, const DisplayList::Item &item,
+                     int16_t dx, int16_t dy)
+{
+  const int16_t *a = item.args;
+  const Color c = item.color;
+
+  switch (item.shape)
+  {
+    case DisplayList::ShapeLine:
+      g.drawLine(a[0] + dx, a[1] + dy, a[2] + dx, a[3] + dy, c);
+      break;
+
+    case DisplayList::ShapeRect:
+      g.drawRect(a[0] + dx, a[1] + dy, a[2], a[3], c);
+      break;
+
+    case DisplayList::ShapeFillRect:
+      g.fillRect(a[0] + dx, a[1] + dy, a[2], a[3], c);
+      break;
+
+    case DisplayList::ShapeRoundRect:
+      g.drawRoundRect(a[0] + dx, a[1] + dy, a[2], a[3], a[4], c);
+      break;
+
+    case DisplayList::ShapeFillRoundRect:
+      g.fillRoundRect(a[0] + dx, a[1] + dy, a[2], a[3], a[4], c);
+      break;
+
+    case DisplayList::ShapeCircle:
+      g.drawCircle(a[0] + dx, a[1] + dy, a[2], c);
+      break;
+
+    case DisplayList::ShapeFillCircle:
+      g.fillCircle(a[0] + dx, a[1] + dy, a[2], c);
+      break;
+
+    case DisplayList::ShapeTriangle:
+      g.drawTriangle(a[0] + dx, a[1] + dy, a[2] + dx, a[3] + dy,
+                     a[4] + dx, a[5] + dy, c);
+      break;
+
+    case DisplayList::ShapeFillTriangle:
+      g.fillTriangle(a[0] + dx, a[1] + dy, a[2] + dx, a[3] + dy,
+                     a[4] + dx, a[5] + dy, c);
+      break;
+
+    case DisplayList::ShapeText:
+      if (item.font != NULL)
+      {
+        g.drawText(a[0] + dx, a[1] + dy, item.text.c_str(), *item.font, c,
+                   item.align);
+      }
+      break;
+  }
+}
+
+
+// How many of an item's arguments are (x, y) points, which move with it.
+static int pointCount(DisplayList::Shape shape)
+{
+  switch (shape)
+  {
+    case DisplayList::ShapeLine:         return 2;
+    case DisplayList::ShapeTriangle:
+    case DisplayList::ShapeFillTriangle: return 3;
+    default:                             return 1;
+  }
+}
+
+
+// Whether b is a moved by (dx, dy) and otherwise the same.
+static bool isMoved(const DisplayList::Item &a, const DisplayList::Item &b,
+                    int16_t *dx, int16_t *dy)
+{
+  if (a.shape != b.shape || a.font != b.font || a.align != b.align ||
+      a.color.red != b.color.red || a.color.green != b.color.green ||
+      a.color.blue != b.color.blue || a.text != b.text)
+  {
+    return false;
+  }
+
+  const int points = pointCount(a.shape);
+
+  *dx = b.args[0] - a.args[0];
+  *dy = b.args[1] - a.args[1];
+
+  for (int i = 0; i < 6; i++)
+  {
+    const int16_t moved = (i >= 2 * points) ? 0 : ((i & 1) ? *dy : *dx);
+
+    if (b.args[i] != a.args[i] + moved) return false;
+  }
+
+  return true;
+}
+
+
+// The pixels an item can cover.
+static Rect itemBounds(const DisplayList::Item &item)
+{
+  const int16_t *a = item.args;
+  Rect r = { a[0], a[1], 0, 0 };
+
+  switch (item.shape)
+  {
+    case DisplayList::ShapeRect:
+    case DisplayList::ShapeFillRect:
+    case DisplayList::ShapeRoundRect:
+    case DisplayList::ShapeFillRoundRect:
+    {
+      // An outline still draws its sides when w or h is 0 or less.
+      const int16_t right = a[0] + a[2] - 1, bottom = a[1] + a[3] - 1;
+
+      r.x = std::min(a[0], right);
+      r.y = std::min(a[1], bottom);
+      r.w = std::max(a[0], right) - r.x + 1;
+      r.h = std::max(a[1], bottom) - r.y + 1;
+      break;
+    }
+
+    case DisplayList::ShapeCircle:
+    case DisplayList::ShapeFillCircle:
+      r.x = a[0] - a[2];
+      r.y = a[1] - a[2];
+      r.w = 2 * a[2] + 1;
+      r.h = 2 * a[2] + 1;
+      break;
+
+    case DisplayList::ShapeText:
+    {
+      if (item.font == NULL) break;
+
+      const Font &font = *item.font;
+      const char *text = item.text.c_str();
+      int16_t x = a[0];
+
+      if (item.align == Graphics::AlignCenter) x -= font.measure(text) / 2;
+      if (item.align == Graphics::AlignRight) x -= font.measure(text);
+
+      int16_t left = x, right = x, top = a[1], bottom = a[1];
+
+      for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+      {
+        const Font::Glyph *g = font.glyph(*c);
+        if (g == NULL) continue;
+
+        left = std::min<int16_t>(left, x + g->xOffset);
+        right = std::max<int16_t>(right, x + g->xOffset + g->width);
+        top = std::min<int16_t>(top, a[1] + g->yOffset);
+        bottom = std::max<int16_t>(bottom, a[1] + g->yOffset + g->height);
+
+        x += g->advance;
+      }
+
+      r.x = left;
+      r.y = top;
+      r.w = right - left;
+      r.h = bottom - top;
+      break;
+    }
+
+    default:
+    {
+      // Lines and triangles: around their points.
+      const int points = pointCount(item.shape);
+      int16_t right = a[0], bottom = a[1];
+
+      for (int i = 1; i < points; i++)
+      {
+        r.x = std::min(r.x, a[2 * i]);
+        r.y = std::min(r.y, a[2 * i + 1]);
+        right = std::max(right, a[2 * i]);
+        bottom = std::max(bottom, a[2 * i + 1]);
+      }
+
+      r.w = right - r.x + 1;
+      r.h = bottom - r.y + 1;
+      break;
+    }
+  }
+
+  return r;
+}
+
+
+void DisplayList::rasterize(const Item &item, Cache &cache,
+                            const RgbMatrix &matrix)
+{
+  delete cache.sprite;
+  cache.sprite = NULL;
+  cache.key = item;
+
+  // Only the part of the item on the display is kept, so items reaching far
+  // off of it don't make huge sprites.
+  Rect r = itemBounds(item);
+
+  const int16_t right = std::min<int32_t>(r.x + r.w, matrix.width());
+  const int16_t bottom = std::min<int32_t>(r.y + r.h, matrix.height());
+
+  cache.whole = r.x >= 0 && r.y >= 0 && right == r.x + r.w &&
+                bottom == r.y + r.h;
+
+  r.x = std::max<int16_t>(r.x, 0);
+  r.y = std::max<int16_t>(r.y, 0);
+  r.w = right - r.x;
+  r.h = bottom - r.y;
+
+  cache.x = r.x;
+  cache.y = r.y;
+
+  if (r.w <= 0 || r.h <= 0) return;
+
+  // Draw the item on a background of another color, which is transparent
+  // in the sprite.
+  Color key;
+  key.red = ~item.color.red;
+  key.green = ~item.color.green;
+  key.blue = ~item.color.blue;
+
+  Canvas canvas(r.w, r.h);
+  canvas.fillScreen(key);
+  drawItem(canvas, item, -r.x, -r.y);
+
+  cache.sprite = new Sprite(canvas, &key);
+}
+
+
+void DisplayList::draw(Graphics &graphics) const
+{
+  for (size_t i = 0; i < _items.size(); i++)
+  {
+    if (_items[i].visible) drawItem(graphics, _items[i], 0, 0);
+  }
+}
+
+
+bool DisplayList::update(int index, const RgbMatrix &matrix)
+{
+  const Item &item = _items[index];
+  Cache &cache = _caches[index];
+
+  const bool shown = cache.shown;
+  cache.shown = item.visible;
+
+  if (!item.visible) return shown;
+
+  int16_t dx, dy;
+
+  if (!isMoved(cache.key, item, &dx, &dy))
+  {
+    rasterize(item, cache, matrix);
+    return true;
+  }
+
+  if (dx == 0 && dy == 0) return !shown;
+
+  if (cache.whole)
+  {
+    // The same pixels somewhere else.
+    cache.key = item;
+    cache.x += dx;
+    cache.y += dy;
+  }
+  else
+  {
+    rasterize(item, cache, matrix);
+  }
+
+  return true;
+}
+
+
+void DisplayList::draw(RgbMatrix &matrix)
+{
+  for (size_t i = 0; i < _items.size(); i++)
+  {
+    if (update(i, matrix)) _frameValid = false;
+
+    const Cache &cache = _caches[i];
+
+    if (_items[i].visible && cache.sprite != NULL)
+    {
+      matrix.drawSprite(*cache.sprite, cache.x, cache.y);
+    }
+  }
+}
+
+
+void DisplayList::drawBackground(RgbMatrix &matrix)
+{
+  bool changed = !_frameValid || _frameMatrix != &matrix;
+
+  for (size_t i = 0; i < _items.size(); i++)
+  {
+    if (update(i, matrix)) changed = true;
+  }
+
+  if (!changed)
+  {
+    matrix.drawFrame(_frame, _frameColors);
+    return;
+  }
+
+  const Rect clip = matrix.clipRect();
+  const Color black = { 0, 0, 0 };
+
+  matrix.resetClipRect();
+  matrix.fillScreen(black);
+
+  for (size_t i = 0; i < _items.size(); i++)
+  {
+    const Cache &cache = _caches[i];
+
+    if (_items[i].visible && cache.sprite != NULL)
+    {
+      matrix.drawSprite(*cache.sprite, cache.x, cache.y);
+    }
+  }
+
+  matrix.setClipRect(clip);
+
+  if (_frame == NULL)
+  {
+    _frame = new RgbMatrix::Frame;
+    _frameColors = new Canvas(matrix.width(), matrix.height());
+  }
+
+  matrix.captureFrame(_frame, _frameColors);
+  _frameMatrix = &matrix;
+  _frameValid = true;
+}
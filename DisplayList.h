@@ -0,0 +1,146 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A recorded sequence of drawing calls (shapes and text), for content
+// that is drawn the same way every frame, like the static parts of a UI.
+//
+// Record the calls once, then draw() the list each frame. On the RGB
+// Matrix every item is rasterized once into a Sprite, which later frames
+// copy into the bit planes. Each cached sprite is kept with the parameters
+// it was drawn with, so changing an item (with item()) only rasterizes
+// that item again; moving a shape that was wholly on the display reuses
+// its sprite at the new position.
+//
+// A list that is the background of every frame (the static parts of a UI)
+// is better drawn with drawBackground(): the whole frame it makes is kept,
+// so frames where no item changed start with a copy of it.
+
+#ifndef RPI_DISPLAYLIST_H
+#define RPI_DISPLAYLIST_H
+
+#include "Canvas.h"
+#include "Font.h"
+#include "Graphics.h"
+#include "RgbMatrix.h"
+#include "Sprite.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+
+class DisplayList
+{
+public:
+
+  enum Shape {
+    ShapeLine,           // args: x0, y0, x1, y1
+    ShapeRect,           // args: x, y, w, h
+    ShapeFillRect,       // args: x, y, w, h
+    ShapeRoundRect,      // args: x, y, w, h, r
+    ShapeFillRoundRect,  // args: x, y, w, h, r
+    ShapeCircle,         // args: x, y, r
+    ShapeFillCircle,     // args: x, y, r
+    ShapeTriangle,       // args: x1, y1, x2, y2, x3, y3
+    ShapeFillTriangle,   // args: x1, y1, x2, y2, x3, y3
+    ShapeText            // args: x, y (with text, font and align)
+  };
+
+  struct Item {
+    Shape shape;
+    int16_t args[6];  // As passed to the Graphics function, in order
+    Color color;
+    std::string text;
+    const Font *font;
+    Graphics::TextAlign align;
+    bool visible;
+  };
+
+
+  DisplayList();
+  ~DisplayList();
+
+  // Record a drawing call. Each returns the index of its item, which is
+  // used to change it later.
+  int drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, Color color);
+  int drawRect(int16_t x, int16_t y, int16_t w, int16_t h, Color color);
+  int fillRect(int16_t x, int16_t y, int16_t w, int16_t h, Color color);
+  int drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r,
+                    Color color);
+  int fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r,
+                    Color color);
+  int drawCircle(int16_t x, int16_t y, int16_t r, Color color);
+  int fillCircle(int16_t x, int16_t y, int16_t r, Color color);
+  int drawTriangle(int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+                   int16_t x3, int16_t y3, Color color);
+  int fillTriangle(int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+                   int16_t x3, int16_t y3, Color color);
+  int drawText(int16_t x, int16_t y, const char *text, const Font &font,
+               Color color, Graphics::TextAlign align = Graphics::AlignLeft);
+  int putChar(int16_t x, int16_t y, unsigned char c, uint8_t size,
+              Color color);
+
+  // Change the item freely; draw() notices what changed.
+  inline Item &item(int index) { return _items[index]; }
+  inline int itemCount() const { return _items.size(); }
+
+  // Remove all items.
+  void clear();
+
+  // Draw the items on any surface, call by call.
+  void draw(Graphics &graphics) const;
+
+  // Draw the items on the matrix from their cached sprites, rasterizing
+  // only the items that are new or changed.
+  void draw(RgbMatrix &matrix);
+
+  // Replace all that is drawn on the matrix with the items over black,
+  // whatever the clip rectangle. If no item changed since the last call,
+  // this only copies the frame made then.
+  void drawBackground(RgbMatrix &matrix);
+
+  // Make drawBackground() draw the items again, after something it can't
+  // see changed (like the color correction of the matrix).
+  inline void invalidate() { _frameValid = false; }
+
+
+private:
+
+  // Not copyable.
+  DisplayList(const DisplayList &);
+  DisplayList &operator=(const DisplayList &);
+
+  // The sprite of an item, and the item as it was when rasterized.
+  struct Cache {
+    Sprite *sprite;  // NULL if nothing of the item is on the display
+    Item key;
+    int16_t x;       // Where the sprite goes
+    int16_t y;
+    bool whole;      // All of the item is in the sprite
+    bool shown;      // Whether the item was visible when last drawn
+  };
+
+  int add(Shape shape, Color color, int16_t a0, int16_t a1, int16_t a2,
+          int16_t a3 = 0, int16_t a4 = 0, int16_t a5 = 0);
+
+  // Bring the cache of an item up to date with it. Returns whether what
+  // the item draws changed.
+  bool update(int index, const RgbMatrix &matrix);
+
+  // Rasterize an item into its cache.
+  void rasterize(const Item &item, Cache &cache, const RgbMatrix &matrix);
+
+  std::vector<Item> _items;
+  std::vector<Cache> _caches;
+
+  // The frame made by drawBackground(), its colors, and the matrix it was
+  // made on.
+  RgbMatrix::Frame *_frame;
+  Canvas *_frameColors;
+  const RgbMatrix *_frameMatrix;
+  bool _frameValid;
+};
+
+#endif
@@ -0,0 +1,52 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Show a stream of images on the RGB Matrix without tearing.
+
+#include "DoubleBuffer.h"
+
+
+DoubleBuffer::DoubleBuffer(RgbMatrix *matrix)
+  : _matrix(matrix), _back(0)
+{
+  _frames[0] = new RgbMatrix::Frame;
+  _frames[1] = new RgbMatrix::Frame;
+}
+
+
+DoubleBuffer::~DoubleBuffer()
+{
+  release();
+
+  delete _frames[0];
+  delete _frames[1];
+}
+
+
+RgbMatrix::Frame *DoubleBuffer::beginFrame()
+{
+  _matrix->waitForRefresh();
+  return _frames[_back];
+}
+
+
+void DoubleBuffer::endFrame()
+{
+  _matrix->showFrame(_frames[_back]);
+  _back ^= 1;
+}
+
+
+void DoubleBuffer::show(const Canvas &canvas)
+{
+  _matrix->convertFrame(canvas, beginFrame());
+  endFrame();
+}
+
+
+void DoubleBuffer::release()
+{
+  _matrix->showFrame(NULL);
+  _matrix->waitForRefresh();
+}
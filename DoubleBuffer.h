@@ -0,0 +1,54 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Two sets of bit planes for showing a stream of images (video, frames
+// received over the network) on the RGB Matrix without tearing.
+//
+// Each image is converted into the frame that isn't shown, which is then
+// swapped in with RgbMatrix::showFrame(). The frame swapped out was hidden
+// by the last swap, but a refresh that started before it may still be
+// scanning it, so it is only converted into again after that refresh.
+
+#ifndef RPI_DOUBLEBUFFER_H
+#define RPI_DOUBLEBUFFER_H
+
+#include "Canvas.h"
+#include "RgbMatrix.h"
+
+
+class DoubleBuffer
+{
+public:
+
+  DoubleBuffer(RgbMatrix *matrix);
+
+  // Shows what is drawn on the matrix again before freeing the frames.
+  ~DoubleBuffer();
+
+  // The frame to convert the next image into, then show it with endFrame().
+  // Waits for a refresh still scanning it.
+  RgbMatrix::Frame *beginFrame();
+  void endFrame();
+
+  // Convert canvas (with its top left at the top left of the display) and
+  // show it.
+  void show(const Canvas &canvas);
+
+  // Show what is drawn on the matrix again, and wait for a refresh still
+  // scanning either frame. The next frame shown is converted from scratch.
+  void release();
+
+
+private:
+
+  DoubleBuffer(const DoubleBuffer &);
+  DoubleBuffer &operator=(const DoubleBuffer &);
+
+  RgbMatrix *const _matrix;
+
+  RgbMatrix::Frame *_frames[2];
+  int _back;  // The frame that isn't shown
+};
+
+#endif
@@ -0,0 +1,257 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A bitmap font with proportional glyph widths.
+
+#include "Font.h"
+
+#include "Font3x5.h"
+#include "Font4x6.h"
+#include "Font5x7.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+Font::Font()
+{
+  clear();
+}
+
+
+const Font &Font::builtIn(uint8_t size)
+{
+  // Each font is built the first time it is asked for. The compiler guards
+  // the initialization of local statics, so threads can ask at the same time.
+  if (size == 1) //small (3x5)
+  {
+    static const Font small = fixedFont(Font3x5, 3, 5);
+    return small;
+  }
+  else if (size == 2) //medium (4x6)
+  {
+    static const Font medium = fixedFont(Font4x6, 4, 6);
+    return medium;
+  }
+
+  //large (5x7)
+  static const Font large = fixedFont(Font5x7, 5, 7);
+  return large;
+}
+
+
+Font Font::fixedFont(const unsigned char *table, uint8_t width, uint8_t height)
+{
+  Font font;
+  font.loadFixed(table, width, height);
+  return font;
+}
+
+
+bool Font::loadBdf(const char *filename)
+{
+  FILE *f = fopen(filename, "r");
+  if (f == NULL)
+  {
+    perror(filename);
+    return false;
+  }
+
+  clear();
+
+  char line[256];
+  int boxHeight = 0, boxYOffset = 0;
+  int ascent = -1, descent = -1;
+
+  // Current character
+  int encoding = -1;
+  int advance = 0;
+  int w = 0, h = 0, xo = 0, yo = 0;
+  std::vector<uint32_t> rows;
+  bool inBitmap = false;
+
+  // The glyphs can only be placed once the ascent is known, which is given
+  // in the header before any of them, so a single pass is enough.
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    if (inBitmap)
+    {
+      if (strncmp(line, "ENDCHAR", 7) == 0)
+      {
+        inBitmap = false;
+
+        if (encoding >= 0 && encoding < 256)
+        {
+          if (ascent < 0) ascent = boxHeight + boxYOffset;
+
+          Glyph g;
+          g.width = (w > MaxGlyphWidth) ? MaxGlyphWidth : w;
+          g.height = rows.size();
+          g.xOffset = xo;
+          g.yOffset = ascent - (yo + h);
+          g.advance = advance;
+          addGlyph(encoding, g, rows.empty() ? NULL : &rows[0]);
+        }
+        continue;
+      }
+
+      // Each row is a hex number, MSB is the leftmost pixel.
+      uint32_t mask = 0;
+      int pixel = 0;
+
+      for (const char *p = line; isxdigit(*p); p++, pixel += 4)
+      {
+        const int nibble = isdigit(*p) ? (*p - '0') : (tolower(*p) - 'a' + 10);
+
+        for (int bit = 0; bit < 4; bit++)
+        {
+          const int x = pixel + bit;
+
+          if (x < w && x < MaxGlyphWidth && (nibble & (0x8 >> bit)))
+          {
+            mask |= 1u << x;
+          }
+        }
+      }
+
+      rows.push_back(mask);
+    }
+    else if (strncmp(line, "FONT_BOUNDINGBOX ", 17) == 0)
+    {
+      int boxWidth, boxXOffset;
+      sscanf(line + 17, "%d %d %d %d", &boxWidth, &boxHeight, &boxXOffset, &boxYOffset);
+    }
+    else if (strncmp(line, "FONT_ASCENT ", 12) == 0)
+    {
+      ascent = atoi(line + 12);
+    }
+    else if (strncmp(line, "FONT_DESCENT ", 13) == 0)
+    {
+      descent = atoi(line + 13);
+    }
+    else if (strncmp(line, "STARTCHAR", 9) == 0)
+    {
+      encoding = -1;
+      advance = w = h = xo = yo = 0;
+    }
+    else if (strncmp(line, "ENCODING ", 9) == 0)
+    {
+      encoding = atoi(line + 9);
+    }
+    else if (strncmp(line, "DWIDTH ", 7) == 0)
+    {
+      advance = atoi(line + 7);
+    }
+    else if (strncmp(line, "BBX ", 4) == 0)
+    {
+      sscanf(line + 4, "%d %d %d %d", &w, &h, &xo, &yo);
+    }
+    else if (strncmp(line, "BITMAP", 6) == 0)
+    {
+      rows.clear();
+      inBitmap = true;
+    }
+  }
+
+  fclose(f);
+
+  if (ascent < 0) ascent = boxHeight + boxYOffset;
+  if (descent < 0) descent = -boxYOffset;
+
+  _ascent = ascent;
+  _height = ascent + descent;
+
+  if (_glyphs.empty())
+  {
+    fprintf(stderr, "%s: No glyphs found.\n", filename);
+    return false;
+  }
+
+  return true;
+}
+
+
+int16_t Font::measure(const char *text) const
+{
+  int16_t width = 0;
+
+  for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+  {
+    const Glyph *g = glyph(*c);
+    if (g) width += g->advance;
+  }
+
+  return width;
+}
+
+
+// The fixed width tables are column-major: one byte per column, bit 0 is the
+// top row. They hold the 96 characters from 0x20 (space) to 0x7F.
+void Font::loadFixed(const unsigned char *table, uint8_t width, uint8_t height)
+{
+  clear();
+
+  uint32_t rows[8];
+
+  for (int c = 0x20; c < 0x80; c++)
+  {
+    const unsigned char *columns = table + (c - 0x20) * width;
+
+    for (int j = 0; j < height; j++)
+    {
+      rows[j] = 0;
+
+      for (int i = 0; i < width; i++)
+      {
+        if (columns[i] & (1 << j)) rows[j] |= 1u << i;
+      }
+    }
+
+    Glyph g;
+    g.width = width;
+    g.height = height;
+    g.xOffset = 0;
+    g.yOffset = 0;
+    g.advance = width + 1;
+    addGlyph(c, g, rows);
+  }
+
+  _height = height + 1;
+  _ascent = height;
+}
+
+
+void Font::clear()
+{
+  for (int c = 0; c < 256; c++)
+  {
+    _index[c] = -1;
+  }
+
+  _glyphs.clear();
+  _atlas.clear();
+  _height = 0;
+  _ascent = 0;
+}
+
+
+void Font::addGlyph(unsigned char c, const Glyph &g, const uint32_t *rows)
+{
+  Glyph copy = g;
+  copy.offset = _atlas.size();
+
+  _atlas.insert(_atlas.end(), rows, rows + g.height);
+
+  if (_index[c] < 0)
+  {
+    _index[c] = _glyphs.size();
+    _glyphs.push_back(copy);
+  }
+  else
+  {
+    _glyphs[_index[c]] = copy;
+  }
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A bitmap font with proportional glyph widths.
+//
+// All glyphs of a font are stored in one atlas: an array of row masks where
+// bit i of a row is the pixel in column i of the glyph (LSB is the leftmost
+// column). Drawing a glyph is a walk over its rows, never a lookup per pixel.
+//
+// Fonts are either one of the three built-in fixed width fonts (the same ones
+// used by RgbMatrix::putChar()) or loaded from a BDF file.
+
+#ifndef RPI_FONT_H
+#define RPI_FONT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+
+class Font
+{
+public:
+
+  // Widest glyph that fits in a row mask.
+  static const int MaxGlyphWidth = 32;
+
+  struct Glyph {
+    uint8_t width;     // Width of the bitmap
+    uint8_t height;    // Height of the bitmap
+    int8_t xOffset;    // From the pen position to the left of the bitmap
+    int8_t yOffset;    // From the top of the line to the top of the bitmap
+    uint8_t advance;   // Distance to move the pen after drawing the glyph
+    uint32_t offset;   // Index of the first row in the atlas
+  };
+
+
+  Font();
+
+  // One of the built-in fixed width fonts.
+  //   size = 1 : Small  (3x5)
+  //        = 2 : Medium (4x6)
+  //        = 3 : Large  (5x7)
+  static const Font &builtIn(uint8_t size);
+
+  // Load a font from a BDF (Glyph Bitmap Distribution Format) file.
+  // Only characters 0-255 are loaded. Returns false if the file can't be read.
+  bool loadBdf(const char *filename);
+
+  // The glyph for character c, or NULL if the font doesn't have it.
+  inline const Glyph *glyph(unsigned char c) const
+  {
+    return (_index[c] < 0) ? NULL : &_glyphs[_index[c]];
+  }
+
+  // The row masks of a glyph, one per row of its bitmap.
+  inline const uint32_t *rows(const Glyph &g) const
+  {
+    // Not &_atlas[g.offset], which is out of range for a glyph with no rows
+    // stored last, or in a font with no rows at all.
+    return _atlas.data() + g.offset;
+  }
+
+  // Height of a line of text.
+  inline uint8_t height() const { return _height; }
+
+  // Distance from the top of the line to the baseline.
+  inline uint8_t ascent() const { return _ascent; }
+
+  // Width of the given text in pixels (the sum of the glyph advances).
+  int16_t measure(const char *text) const;
+
+
+private:
+
+  // Load one of the column-major fixed width tables (Font3x5, ...).
+  void loadFixed(const unsigned char *table, uint8_t width, uint8_t height);
+
+  // A font loaded from one of the fixed width tables.
+  static Font fixedFont(const unsigned char *table, uint8_t width,
+                        uint8_t height);
+
+  void clear();
+
+  void addGlyph(unsigned char c, const Glyph &g, const uint32_t *rows);
+
+  int16_t _index[256];          // Glyph index per character, -1 if missing
+  std::vector<Glyph> _glyphs;
+  std::vector<uint32_t> _atlas;
+
+  uint8_t _height;
+  uint8_t _ascent;
+};
+
+#endif
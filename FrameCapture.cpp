@@ -0,0 +1,164 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Save what the RGB Matrix shows to a PPM image every so often.
+
+#include "FrameCapture.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <time.h>
+
+
+static void addMillis(struct timespec *t, long ms)
+{
+  t->tv_sec += ms / 1000;
+  t->tv_nsec += (ms % 1000) * 1000000L;
+
+  if (t->tv_nsec >= 1000000000L)
+  {
+    t->tv_sec++;
+    t->tv_nsec -= 1000000000L;
+  }
+}
+
+
+static bool isBefore(const struct timespec &a, const struct timespec &b)
+{
+  return a.tv_sec < b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_nsec < b.tv_nsec);
+}
+
+
+FrameCapture::FrameCapture(const RgbMatrix *matrix)
+  : _matrix(matrix), _intervalMs(1000), _threadRunning(false),
+    _stopping(false), _captures(0)
+{
+  pthread_mutex_init(&_mutex, NULL);
+
+  // Time the waits with the monotonic clock, which setting the time of day
+  // (e.g. NTP at boot on a Pi without a clock) doesn't move.
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&_stop, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+
+FrameCapture::~FrameCapture()
+{
+  stop();
+
+  pthread_cond_destroy(&_stop);
+  pthread_mutex_destroy(&_mutex);
+}
+
+
+bool FrameCapture::start(const char *filename, int intervalMs)
+{
+  stop();
+
+  if (intervalMs <= 0)
+  {
+    fprintf(stderr, "FrameCapture: The interval must be positive.\n");
+    return false;
+  }
+
+  _filename = filename;
+  _intervalMs = intervalMs;
+  _stopping = false;
+
+  if (pthread_create(&_thread, NULL, captureThread, this) != 0)
+  {
+    perror("FrameCapture");
+    return false;
+  }
+
+  _threadRunning = true;
+  return true;
+}
+
+
+void FrameCapture::stop()
+{
+  if (!_threadRunning) return;
+
+  pthread_mutex_lock(&_mutex);
+  _stopping = true;
+  pthread_cond_signal(&_stop);
+  pthread_mutex_unlock(&_mutex);
+
+  pthread_join(_thread, NULL);
+  _threadRunning = false;
+}
+
+
+bool FrameCapture::capture(const char *filename)
+{
+  // Its own canvas, as the capture thread may be capturing at the same time.
+  Canvas canvas(RgbMatrix::Width, RgbMatrix::Height);
+  _matrix->readFrame(&canvas);
+
+  // Replace the file in one step.
+  const std::string temporary = std::string(filename) + ".tmp";
+
+  if (!canvas.savePpm(temporary.c_str())) return false;
+
+  if (rename(temporary.c_str(), filename) != 0)
+  {
+    perror(filename);
+    remove(temporary.c_str());
+    return false;
+  }
+
+  __sync_fetch_and_add(&_captures, 1);
+  return true;
+}
+
+
+void *FrameCapture::captureThread(void *capture)
+{
+  ((FrameCapture *)capture)->captureFrames();
+  return NULL;
+}
+
+
+void FrameCapture::captureFrames()
+{
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+  pthread_mutex_lock(&_mutex);
+
+  while (!_stopping)
+  {
+    pthread_mutex_unlock(&_mutex);
+    capture(_filename.c_str());
+    pthread_mutex_lock(&_mutex);
+
+    // Wait for the next capture time, or until stopped. Captures keep to
+    // the interval however long saving takes.
+    addMillis(&deadline, _intervalMs);
+
+    // If saving fell behind, wait a whole interval from now instead of
+    // capturing back to back to catch up.
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (isBefore(deadline, now))
+    {
+      deadline = now;
+      addMillis(&deadline, _intervalMs);
+    }
+
+    int result = 0;
+
+    while (!_stopping && result != ETIMEDOUT)
+    {
+      result = pthread_cond_timedwait(&_stop, &_mutex, &deadline);
+    }
+  }
+
+  pthread_mutex_unlock(&_mutex);
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Save what the RGB Matrix shows to a PPM image every so often, e.g. to
+// check on a deployed sign from afar or to compare against expected frames.
+//
+// A thread of its own reads the colors back out of the bit planes being
+// shown (RgbMatrix::readFrame()), without locking, so capturing never holds
+// up the refresh or drawing. Each image is written to a temporary file and
+// renamed over the last one, so whoever reads the file always gets a whole
+// image.
+
+#ifndef RPI_FRAMECAPTURE_H
+#define RPI_FRAMECAPTURE_H
+
+#include "Canvas.h"
+#include "RgbMatrix.h"
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <string>
+
+
+class FrameCapture
+{
+public:
+
+  FrameCapture(const RgbMatrix *matrix);
+  ~FrameCapture();
+
+  // Start saving to filename every intervalMs, starting now.
+  bool start(const char *filename, int intervalMs);
+
+  // Stop saving (the last image stays).
+  void stop();
+
+  // Save one image now, on the calling thread (even while started).
+  bool capture(const char *filename);
+
+  inline uint32_t captures() const { return _captures; }
+
+
+private:
+
+  FrameCapture(const FrameCapture &);
+  FrameCapture &operator=(const FrameCapture &);
+
+  static void *captureThread(void *capture);
+  void captureFrames();
+
+  const RgbMatrix *const _matrix;
+
+  std::string _filename;
+  long _intervalMs;
+
+  pthread_t _thread;
+  bool _threadRunning;
+  pthread_mutex_t _mutex;
+  pthread_cond_t _stop;  // Signaled to wake the thread when stopping
+
+  // Shared with the capture thread (under _mutex).
+  bool _stopping;
+  volatile uint32_t _captures;
+};
+
+#endif
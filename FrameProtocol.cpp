@@ -0,0 +1,126 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Datagram protocol for sending frames to a display.
+
+#include "FrameProtocol.h"
+
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/un.h>
+
+
+int FrameProtocol::parseAddress(const char *address, struct sockaddr_storage *addr,
+                                socklen_t *addrLength)
+{
+  memset(addr, 0, sizeof(*addr));
+
+  if (strncmp(address, "unix:", 5) == 0)
+  {
+    struct sockaddr_un *un = (struct sockaddr_un *)addr;
+    const char *path = address + 5;
+
+    if (*path == 0 || strlen(path) >= sizeof(un->sun_path)) return -1;
+
+    un->sun_family = AF_UNIX;
+    strcpy(un->sun_path, path);
+    *addrLength = sizeof(struct sockaddr_un);
+
+    return AF_UNIX;
+  }
+
+  if (strncmp(address, "udp:", 4) == 0)
+  {
+    // The port is after the last colon.
+    const char *colon = strrchr(address + 4, ':');
+    if (colon == NULL || colon == address + 4) return -1;
+
+    char host[256];
+    const size_t hostLength = colon - (address + 4);
+    if (hostLength >= sizeof(host)) return -1;
+
+    memcpy(host, address + 4, hostLength);
+    host[hostLength] = 0;
+
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    const int error = getaddrinfo(host, colon + 1, &hints, &result);
+    if (error != 0)
+    {
+      fprintf(stderr, "%s: %s\n", address, gai_strerror(error));
+      return -1;
+    }
+
+    memcpy(addr, result->ai_addr, result->ai_addrlen);
+    *addrLength = result->ai_addrlen;
+
+    const int family = result->ai_family;
+    freeaddrinfo(result);
+
+    return family;
+  }
+
+  return -1;
+}
+
+
+size_t FrameProtocol::encodeRle(const Color *pixels, size_t count,
+                                uint8_t *dst, size_t maxLength)
+{
+  size_t length = 0;
+  size_t i = 0;
+
+  while (i < count)
+  {
+    const Color &c = pixels[i];
+    size_t run = 1;
+
+    while (i + run < count && run < 255 &&
+           pixels[i + run].red == c.red &&
+           pixels[i + run].green == c.green &&
+           pixels[i + run].blue == c.blue)
+    {
+      run++;
+    }
+
+    if (length + 4 > maxLength) return 0;
+
+    dst[length++] = run;
+    dst[length++] = c.red;
+    dst[length++] = c.green;
+    dst[length++] = c.blue;
+
+    i += run;
+  }
+
+  return length;
+}
+
+
+bool FrameProtocol::decodeRle(const uint8_t *src, size_t length,
+                              Color *pixels, size_t count)
+{
+  size_t n = 0;
+
+  for (size_t i = 0; i + 4 <= length; i += 4)
+  {
+    const size_t run = src[i];
+
+    if (run == 0 || n + run > count) return false;
+
+    const Color c = { src[i + 1], src[i + 2], src[i + 3] };
+
+    for (size_t j = 0; j < run; j++)
+    {
+      pixels[n++] = c;
+    }
+  }
+
+  return n == count && length % 4 == 0;
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Datagram protocol for sending frames to a display over UDP or a Unix
+// socket (see FrameSender and FrameReceiver).
+//
+// A frame is sent as one or more packets, each with a rectangle of pixels
+// (row-major RGB, optionally run-length encoded). All packets of a frame
+// carry its sequence number and the packet count, so the receiver knows
+// when a frame is complete and applies it whole.
+//
+// Key frames cover the whole display. Delta frames only carry the rectangles
+// that changed since the frame before, so they're skipped after a frame is
+// lost, until the next key frame. Frame numbers start again when a sender
+// restarts; the stream id tells the receiver to start over too.
+//
+// Multi-byte header fields are in network byte order.
+
+#ifndef RPI_FRAMEPROTOCOL_H
+#define RPI_FRAMEPROTOCOL_H
+
+#include "Graphics.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+
+class FrameProtocol
+{
+public:
+
+  static const uint8_t Version = 1;
+
+  // Largest payload, so packets fit in one Ethernet frame.
+  static const int MaxPayload = 1400;
+
+  // Largest packet.
+  static const int MaxPacket = 1432;
+
+  enum Flags {
+    FlagKeyFrame = 0x01,  // The frame covers the whole display
+    FlagRle = 0x02        // The payload is run-length encoded
+  };
+
+  struct PacketHeader {
+    uint8_t magic[2];      // "RF"
+    uint8_t version;
+    uint8_t flags;
+    uint32_t frame;        // Sequence number of the frame
+    uint32_t sentSec;      // When the frame was sent (CLOCK_REALTIME)
+    uint32_t sentUsec;
+    uint16_t packet;       // Index of this packet in the frame
+    uint16_t packetCount;  // Packets in the frame
+    int16_t x;             // Rectangle of the pixels
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t length;       // Bytes of payload after the header
+    uint16_t stream;       // Picked at random by the sender, so the receiver
+                           // knows when a sender restarted
+  };
+
+  // Parse "udp:host:port" or "unix:/path" into a socket address.
+  // Returns the address family, or -1 if the address is bad.
+  static int parseAddress(const char *address, struct sockaddr_storage *addr,
+                          socklen_t *addrLength);
+
+  // Run-length encode count pixels as (run length, red, green, blue) runs.
+  // Returns the encoded size, or 0 if it wouldn't fit in maxLength.
+  static size_t encodeRle(const Color *pixels, size_t count,
+                          uint8_t *dst, size_t maxLength);
+
+  // Decode runs into exactly count pixels. Returns false if the data
+  // doesn't hold exactly count pixels.
+  static bool decodeRle(const uint8_t *src, size_t length,
+                        Color *pixels, size_t count);
+};
+
+#endif
@@ -0,0 +1,325 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Receive frames sent by a FrameSender.
+
+#include "FrameReceiver.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+FrameReceiver::FrameReceiver(int16_t width, int16_t height)
+  : _socket(-1), _path(NULL),
+    _frame(new Canvas(width, height)), _assembly(new Canvas(width, height)),
+    _assembling(false), _assemblyNumber(0), _assemblyKey(false),
+    _receivedCount(0), _synced(false), _anyFrame(false), _stream(0),
+    _lastNumber(0),
+    _buffers(new uint8_t[BatchSize][FrameProtocol::MaxPacket])
+{
+  resetStats();
+}
+
+
+FrameReceiver::~FrameReceiver()
+{
+  close();
+
+  delete _frame;
+  delete _assembly;
+  delete [] _buffers;
+}
+
+
+bool FrameReceiver::open(const char *address)
+{
+  close();
+
+  struct sockaddr_storage addr;
+  socklen_t addrLength;
+
+  const int family = FrameProtocol::parseAddress(address, &addr, &addrLength);
+
+  if (family < 0)
+  {
+    fprintf(stderr, "%s: Bad address (udp:host:port or unix:/path).\n", address);
+    return false;
+  }
+
+  _socket = socket(family, SOCK_DGRAM, 0);
+
+  if (_socket < 0)
+  {
+    perror(address);
+    return false;
+  }
+
+  // Room for bursts of packets while the display is busy.
+  int bufferSize = 1 << 20;
+  setsockopt(_socket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+  if (family == AF_UNIX)
+  {
+    // Remove the socket file a receiver before us left behind.
+    const char *path = ((struct sockaddr_un *)&addr)->sun_path;
+    unlink(path);
+    _path = strdup(path);
+  }
+
+  if (bind(_socket, (struct sockaddr *)&addr, addrLength) < 0)
+  {
+    perror(address);
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+
+void FrameReceiver::close()
+{
+  if (_socket >= 0) ::close(_socket);
+
+  if (_path)
+  {
+    unlink(_path);
+    free(_path);
+  }
+
+  _socket = -1;
+  _path = NULL;
+  _assembling = false;
+  _synced = false;
+  _anyFrame = false;
+}
+
+
+void FrameReceiver::resetStats()
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+
+bool FrameReceiver::receive(int timeoutMs)
+{
+  struct pollfd p;
+  p.fd = _socket;
+  p.events = POLLIN;
+
+  if (poll(&p, 1, timeoutMs) <= 0) return false;
+
+  struct mmsghdr messages[BatchSize];
+  struct iovec iov[BatchSize];
+
+  bool completed = false;
+
+  // Take everything that is waiting, a batch per call.
+  while (true)
+  {
+    memset(messages, 0, sizeof(messages));
+
+    for (int i = 0; i < BatchSize; i++)
+    {
+      iov[i].iov_base = _buffers[i];
+      iov[i].iov_len = FrameProtocol::MaxPacket;
+      messages[i].msg_hdr.msg_iov = &iov[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    const int n = recvmmsg(_socket, messages, BatchSize, MSG_DONTWAIT, NULL);
+
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+
+    _stats.receiveCalls++;
+
+    for (int i = 0; i < n; i++)
+    {
+      if (messages[i].msg_hdr.msg_flags & MSG_TRUNC)
+      {
+        _stats.packets++;
+        _stats.packetsBad++;
+        continue;
+      }
+
+      if (processPacket(_buffers[i], messages[i].msg_len)) completed = true;
+    }
+
+    if (n < BatchSize) break;
+  }
+
+  return completed;
+}
+
+
+bool FrameReceiver::processPacket(const uint8_t *packet, size_t length)
+{
+  _stats.packets++;
+
+  const FrameProtocol::PacketHeader *header = (const FrameProtocol::PacketHeader *)packet;
+
+  if (length < sizeof(*header) || memcmp(header->magic, "RF", 2) != 0 ||
+      header->version != FrameProtocol::Version)
+  {
+    _stats.packetsBad++;
+    return false;
+  }
+
+  const uint32_t number = ntohl(header->frame);
+  const uint16_t index = ntohs(header->packet);
+  const uint16_t packetCount = ntohs(header->packetCount);
+  const int16_t x = ntohs(header->x);
+  const int16_t y = ntohs(header->y);
+  const uint16_t w = ntohs(header->w);
+  const uint16_t h = ntohs(header->h);
+  const uint16_t payloadLength = ntohs(header->length);
+  const uint8_t *payload = packet + sizeof(*header);
+
+  if (payloadLength != length - sizeof(*header) || index >= packetCount ||
+      x < 0 || y < 0 || x + w > _frame->width() || y + h > _frame->height() ||
+      (size_t)w * h > FrameProtocol::MaxPayload / sizeof(Color))
+  {
+    _stats.packetsBad++;
+    return false;
+  }
+
+  // Decode the pixels before touching the frame being assembled.
+  Color pixels[FrameProtocol::MaxPayload / sizeof(Color)];
+
+  if (header->flags & FrameProtocol::FlagRle)
+  {
+    if (!FrameProtocol::decodeRle(payload, payloadLength, pixels, w * h))
+    {
+      _stats.packetsBad++;
+      return false;
+    }
+  }
+  else
+  {
+    if (payloadLength != w * h * sizeof(Color))
+    {
+      _stats.packetsBad++;
+      return false;
+    }
+
+    memcpy(pixels, payload, payloadLength);
+  }
+
+  // A sender that restarted numbers its frames from 0 again.
+  const uint16_t stream = ntohs(header->stream);
+
+  if (stream != _stream)
+  {
+    _stream = stream;
+    _anyFrame = false;
+    _assembling = false;
+    _synced = false;
+  }
+
+  // Sequence numbers wrap, so compare their difference.
+  if ((_anyFrame && (int32_t)(number - _lastNumber) <= 0) ||
+      (_assembling && (int32_t)(number - _assemblyNumber) < 0))
+  {
+    _stats.packetsLate++;
+    return false;
+  }
+
+  if (!_assembling || number != _assemblyNumber)
+  {
+    startFrame(number, packetCount, (header->flags & FrameProtocol::FlagKeyFrame) != 0);
+  }
+
+  if ((int)_received.size() != packetCount)
+  {
+    _stats.packetsBad++;
+    return false;
+  }
+
+  if (_received[index]) return false;  // Duplicate
+
+  _received[index] = true;
+  _receivedCount++;
+
+  for (int j = 0; j < h; j++)
+  {
+    memcpy(_assembly->row(y + j) + x, pixels + j * w, w * sizeof(Color));
+  }
+
+  if (_receivedCount < packetCount) return false;
+
+  // The frame is complete.
+  _assembling = false;
+  _anyFrame = true;
+  _lastNumber = number;
+
+  if (!_assemblyKey && !_synced)
+  {
+    // A delta on top of a frame that was lost.
+    _stats.framesDropped++;
+    return false;
+  }
+
+  Canvas *swap = _frame;
+  _frame = _assembly;
+  _assembly = swap;
+
+  _synced = true;
+  _stats.frames++;
+
+  struct timeval now;
+  gettimeofday(&now, NULL);
+
+  // In signed 64 bits: with a 32 bit time_t, tv_sec - an unsigned sentSec
+  // would wrap when the sender's clock is a second ahead.
+  const int64_t latency =
+      ((int64_t)now.tv_sec - (int64_t)ntohl(header->sentSec)) * 1000000 +
+      ((int64_t)now.tv_usec - (int64_t)ntohl(header->sentUsec));
+
+  if (latency > 0)
+  {
+    _stats.latencyTotalUs += latency;
+    if (latency > _stats.latencyMaxUs) _stats.latencyMaxUs = latency;
+  }
+
+  return true;
+}
+
+
+void FrameReceiver::startFrame(uint32_t number, uint16_t packetCount, bool keyFrame)
+{
+  // Frames between the last completed one and this one are lost, including
+  // one that was being assembled.
+  if (_anyFrame)
+  {
+    const uint32_t lost = number - _lastNumber - 1;
+
+    _stats.framesDropped += lost;
+    if (lost) _synced = false;
+  }
+  else if (_assembling)
+  {
+    _stats.framesDropped++;
+  }
+
+  // Deltas only carry what changed, so start from the current frame.
+  for (int y = 0; y < _frame->height(); y++)
+  {
+    memcpy(_assembly->row(y), _frame->row(y), _frame->width() * sizeof(Color));
+  }
+
+  _assembling = true;
+  _assemblyNumber = number;
+  _assemblyKey = keyFrame;
+  _received.assign(packetCount, false);
+  _receivedCount = 0;
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Receive frames sent by a FrameSender (see FrameProtocol.h) on a UDP or
+// Unix datagram socket.
+//
+// Packets are received in batches with recvmmsg(), so a burst of packets
+// costs one system call. A frame is assembled in a second canvas and only
+// becomes the current frame once all of its packets arrived, so a display
+// never shows half a frame. Statistics count the frames, packets and drops,
+// and the latency from sending to the completed frame (which needs the
+// clocks of both machines to be synchronized, e.g. with NTP).
+
+#ifndef RPI_FRAMERECEIVER_H
+#define RPI_FRAMERECEIVER_H
+
+#include "Canvas.h"
+#include "FrameProtocol.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+
+class FrameReceiver
+{
+public:
+
+  struct Stats {
+    uint32_t frames;          // Frames completed
+    uint32_t framesDropped;   // Frames missing packets, or deltas after those
+    uint32_t packets;
+    uint32_t packetsBad;      // Malformed or for the wrong display size
+    uint32_t packetsLate;     // For a frame older than the one assembled
+    uint32_t receiveCalls;    // recvmmsg() calls that returned packets
+    uint32_t latencyMaxUs;
+    uint64_t latencyTotalUs;  // Divide by frames for the average
+  };
+
+
+  // Frames are assembled at this size.
+  FrameReceiver(int16_t width, int16_t height);
+  ~FrameReceiver();
+
+  // Listen on "udp:host:port" or "unix:/path".
+  bool open(const char *address);
+
+  void close();
+
+  // Wait up to timeoutMs for packets and process all that arrived.
+  // Returns true if at least one frame was completed.
+  bool receive(int timeoutMs);
+
+  // The last completed frame.
+  inline const Canvas &frame() const { return *_frame; }
+
+  inline const Stats &stats() const { return _stats; }
+  void resetStats();
+
+
+private:
+
+  FrameReceiver(const FrameReceiver &);
+  FrameReceiver &operator=(const FrameReceiver &);
+
+  // Returns true if the packet completed a frame.
+  bool processPacket(const uint8_t *packet, size_t length);
+
+  // Start assembling a new frame on top of the current one.
+  void startFrame(uint32_t number, uint16_t packetCount, bool keyFrame);
+
+  int _socket;
+  char *_path;  // Socket file to remove on close
+
+  Canvas *_frame;     // Last completed frame
+  Canvas *_assembly;  // Frame being assembled
+
+  bool _assembling;
+  uint32_t _assemblyNumber;
+  bool _assemblyKey;
+  std::vector<bool> _received;  // Packets of the frame being assembled
+  int _receivedCount;
+
+  // Deltas need the frame before; false after a frame was lost.
+  bool _synced;
+  bool _anyFrame;
+  uint16_t _stream;
+  uint32_t _lastNumber;  // Last completed frame
+
+  Stats _stats;
+
+  // Buffers for one batch of packets.
+  static const int BatchSize = 16;
+  uint8_t (*_buffers)[FrameProtocol::MaxPacket];
+};
+
+#endif
@@ -0,0 +1,219 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Send frames to a display running a FrameReceiver.
+
+#include "FrameSender.h"
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+
+FrameSender::FrameSender()
+  : _socket(-1), _addressLength(0), _compress(true), _stream(0), _frame(0),
+    _ok(true)
+{
+}
+
+
+FrameSender::~FrameSender()
+{
+  close();
+}
+
+
+bool FrameSender::open(const char *address)
+{
+  close();
+
+  const int family = FrameProtocol::parseAddress(address, &_address, &_addressLength);
+
+  if (family < 0)
+  {
+    fprintf(stderr, "%s: Bad address (udp:host:port or unix:/path).\n", address);
+    return false;
+  }
+
+  // A new stream id, so a receiver doesn't take the frames for old ones.
+  // rand_r() leaves the application's rand() sequence alone.
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  unsigned int seed = now.tv_sec ^ now.tv_usec ^ (getpid() << 16);
+
+  _stream = rand_r(&seed);
+  _frame = 0;
+
+  _socket = socket(family, SOCK_DGRAM, 0);
+
+  if (_socket < 0)
+  {
+    perror(address);
+    return false;
+  }
+
+  return true;
+}
+
+
+void FrameSender::close()
+{
+  if (_socket >= 0) ::close(_socket);
+
+  _socket = -1;
+}
+
+
+void FrameSender::setCompress(bool compress)
+{
+  _compress = compress;
+}
+
+
+bool FrameSender::sendFrame(const Canvas &canvas)
+{
+  const Rect all = { 0, 0, canvas.width(), canvas.height() };
+  const uint8_t flags = FrameProtocol::FlagKeyFrame;
+
+  const int packetCount = sendRects(canvas, &all, 1, flags, false, 0);
+
+  _ok = true;
+  sendRects(canvas, &all, 1, flags, true, packetCount);
+  _frame++;
+
+  return _ok;
+}
+
+
+bool FrameSender::sendDelta(const Canvas &canvas, const Rect *rects, int rectCount)
+{
+  const int packetCount = sendRects(canvas, rects, rectCount, 0, false, 0);
+
+  _ok = true;
+
+  if (packetCount)
+  {
+    sendRects(canvas, rects, rectCount, 0, true, packetCount);
+  }
+  else
+  {
+    // Nothing changed: still send an empty frame, so the receiver sees every
+    // sequence number.
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    const Rect none = { 0, 0, 0, 0 };
+    sendPacket(0, none, NULL, 0, 1, now);
+  }
+
+  _frame++;
+
+  return _ok;
+}
+
+
+int FrameSender::sendRects(const Canvas &canvas, const Rect *rects, int rectCount,
+                           uint8_t flags, bool send, int packetCount)
+{
+  struct timeval now;
+  gettimeofday(&now, NULL);
+
+  // Widest band of pixels that fits in one packet.
+  const int maxWidth = FrameProtocol::MaxPayload / sizeof(Color);
+
+  Color band[FrameProtocol::MaxPayload / sizeof(Color)];
+  int count = 0;
+
+  for (int r = 0; r < rectCount; r++)
+  {
+    // Clip to the canvas.
+    int x0 = rects[r].x, y0 = rects[r].y;
+    int x1 = x0 + rects[r].w, y1 = y0 + rects[r].h;
+
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > canvas.width()) x1 = canvas.width();
+    if (y1 > canvas.height()) y1 = canvas.height();
+
+    // Split into bands of whole rows that fit in a packet.
+    for (int x = x0; x < x1; x += maxWidth)
+    {
+      const int w = (x1 - x < maxWidth) ? (x1 - x) : maxWidth;
+      const int rowsPerPacket = FrameProtocol::MaxPayload / (w * sizeof(Color));
+
+      for (int y = y0; y < y1; y += rowsPerPacket)
+      {
+        const int h = (y1 - y < rowsPerPacket) ? (y1 - y) : rowsPerPacket;
+
+        if (send)
+        {
+          for (int j = 0; j < h; j++)
+          {
+            memcpy(band + j * w, canvas.row(y + j) + x, w * sizeof(Color));
+          }
+
+          Rect rect;
+          rect.x = x;
+          rect.y = y;
+          rect.w = w;
+          rect.h = h;
+
+          sendPacket(flags, rect, band, count, packetCount, now);
+        }
+
+        count++;
+      }
+    }
+  }
+
+  return count;
+}
+
+
+void FrameSender::sendPacket(uint8_t flags, const Rect &rect, const Color *pixels,
+                             int packet, int packetCount, const struct timeval &sent)
+{
+  uint8_t buffer[FrameProtocol::MaxPacket];
+  FrameProtocol::PacketHeader *header = (FrameProtocol::PacketHeader *)buffer;
+  uint8_t *payload = buffer + sizeof(FrameProtocol::PacketHeader);
+
+  const size_t count = rect.w * rect.h;
+  const size_t rawLength = count * sizeof(Color);
+  size_t length = 0;
+
+  // Only use run-length encoding when it's smaller.
+  if (_compress && count > 0)
+  {
+    length = FrameProtocol::encodeRle(pixels, count, payload, rawLength - 1);
+    if (length) flags |= FrameProtocol::FlagRle;
+  }
+
+  if (length == 0 && count > 0)
+  {
+    memcpy(payload, pixels, rawLength);
+    length = rawLength;
+  }
+
+  memcpy(header->magic, "RF", 2);
+  header->version = FrameProtocol::Version;
+  header->flags = flags;
+  header->frame = htonl(_frame);
+  header->sentSec = htonl(sent.tv_sec);
+  header->sentUsec = htonl(sent.tv_usec);
+  header->packet = htons(packet);
+  header->packetCount = htons(packetCount);
+  header->x = htons(rect.x);
+  header->y = htons(rect.y);
+  header->w = htons(rect.w);
+  header->h = htons(rect.h);
+  header->length = htons(length);
+  header->stream = htons(_stream);
+
+  if (sendto(_socket, buffer, sizeof(*header) + length, 0,
+             (struct sockaddr *)&_address, _addressLength) < 0)
+    _ok = false;
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Send frames drawn on a Canvas to a display running a FrameReceiver
+// (see FrameProtocol.h).
+
+#ifndef RPI_FRAMESENDER_H
+#define RPI_FRAMESENDER_H
+
+#include "Canvas.h"
+#include "FrameProtocol.h"
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+
+class FrameSender
+{
+public:
+
+  FrameSender();
+  ~FrameSender();
+
+  // Send to "udp:host:port" or "unix:/path".
+  bool open(const char *address);
+
+  void close();
+
+  // Run-length encode packets when that makes them smaller. On by default.
+  void setCompress(bool compress);
+
+  // Send the whole canvas as a key frame.
+  bool sendFrame(const Canvas &canvas);
+
+  // Send only the given rectangles of the canvas, which changed since the
+  // frame sent before.
+  bool sendDelta(const Canvas &canvas, const Rect *rects, int rectCount);
+
+  // Sequence number of the next frame.
+  inline uint32_t frameNumber() const { return _frame; }
+
+
+private:
+
+  FrameSender(const FrameSender &);
+  FrameSender &operator=(const FrameSender &);
+
+  // Split the rectangles into packets; send them if send is true.
+  // Returns the number of packets.
+  int sendRects(const Canvas &canvas, const Rect *rects, int rectCount,
+                uint8_t flags, bool send, int packetCount);
+
+  void sendPacket(uint8_t flags, const Rect &rect, const Color *pixels,
+                  int packet, int packetCount, const struct timeval &sent);
+
+  int _socket;
+  struct sockaddr_storage _address;
+  socklen_t _addressLength;
+
+  bool _compress;
+  uint16_t _stream;
+  uint32_t _frame;
+  bool _ok;
+};
+
+#endif
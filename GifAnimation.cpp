@@ -0,0 +1,100 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// An animated GIF, decoded and converted into bit planes when it is loaded.
+
+#include "GifAnimation.h"
+#include "GifDecoder.h"
+#include "Resampler.h"
+
+
+GifAnimation::GifAnimation(RgbMatrix *matrix)
+  : _matrix(matrix), _loopCount(0)
+{
+}
+
+
+GifAnimation::~GifAnimation()
+{
+  clear();
+}
+
+
+bool GifAnimation::load(const char *filename, bool fit)
+{
+  clear();
+
+  GifDecoder gif;
+
+  if (!gif.open(filename)) return false;
+
+  const int16_t x = (RgbMatrix::Width - gif.width()) / 2;
+  const int16_t y = (RgbMatrix::Height - gif.height()) / 2;
+
+  // Images that already fit are shown as they are.
+  if (gif.width() <= RgbMatrix::Width && gif.height() <= RgbMatrix::Height)
+    fit = false;
+
+  Resampler resampler;
+  Canvas scaled(RgbMatrix::Width, RgbMatrix::Height);
+  const Rect rect = Resampler::fitRect(gif.width(), gif.height(),
+                                       RgbMatrix::Width, RgbMatrix::Height);
+
+  while (gif.nextFrame())
+  {
+    RgbMatrix::Frame *frame = new RgbMatrix::Frame;
+
+    if (fit)
+    {
+      const Rect all = { 0, 0, gif.width(), gif.height() };
+
+      resampler.resample(gif.screen(), all, &scaled, rect);
+      _matrix->convertFrame(scaled, frame);
+    }
+    else
+    {
+      _matrix->convertFrame(gif.screen(), frame, x, y);
+    }
+
+    _frames.push_back(frame);
+    _delays.push_back(gif.delayMs());
+  }
+
+  _loopCount = gif.loopCount();
+
+  return !_frames.empty();
+}
+
+
+void GifAnimation::clear()
+{
+  // Don't free a frame the matrix may still be showing, or scanning in a
+  // refresh that started before it was hidden.
+  if (!_frames.empty())
+  {
+    hide();
+    _matrix->waitForRefresh();
+  }
+
+  for (size_t i = 0; i < _frames.size(); i++)
+  {
+    delete _frames[i];
+  }
+
+  _frames.clear();
+  _delays.clear();
+  _loopCount = 0;
+}
+
+
+void GifAnimation::show(int i)
+{
+  _matrix->showFrame(_frames[i]);
+}
+
+
+void GifAnimation::hide()
+{
+  _matrix->showFrame(NULL);
+}
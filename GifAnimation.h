@@ -0,0 +1,63 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// An animated GIF, decoded and converted into bit planes when it is loaded.
+//
+// Every frame is converted ahead of time into an RgbMatrix::Frame, so playing
+// the animation only swaps which frame the matrix scans out; no decoding or
+// color conversion happens while it plays.
+
+#ifndef RPI_GIFANIMATION_H
+#define RPI_GIFANIMATION_H
+
+#include "RgbMatrix.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+
+class GifAnimation
+{
+public:
+
+  GifAnimation(RgbMatrix *matrix);
+  ~GifAnimation();
+
+  // Decode all frames of a GIF file. The animation is centered on the
+  // display; larger images are cropped, unless fit is set, which scales them
+  // to fit keeping their aspect ratio.
+  bool load(const char *filename, bool fit = false);
+
+  // Stop showing the animation and free all frames.
+  void clear();
+
+  inline int frameCount() const { return _frames.size(); }
+
+  // How long frame i should be shown, in milliseconds.
+  inline int delayMs(int i) const { return _delays[i]; }
+
+  // Number of times to play the animation after the first time (0: forever).
+  inline uint16_t loopCount() const { return _loopCount; }
+
+  // Show frame i on the matrix.
+  void show(int i);
+
+  // Show what is drawn on the matrix again.
+  void hide();
+
+
+private:
+
+  GifAnimation(const GifAnimation &);
+  GifAnimation &operator=(const GifAnimation &);
+
+  RgbMatrix *const _matrix;
+
+  std::vector<RgbMatrix::Frame *> _frames;
+  std::vector<int> _delays;
+  uint16_t _loopCount;
+};
+
+#endif
@@ -0,0 +1,458 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Streaming decoder for (animated) GIF images.
+//
+// Based on the GIF89a specification:
+//   http://www.w3.org/Graphics/GIF/spec-gif89a.txt
+
+#include "GifDecoder.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+
+GifDecoder::GifDecoder() : _file(NULL), _screen(NULL), _previous(NULL)
+{
+  close();
+}
+
+
+GifDecoder::~GifDecoder()
+{
+  close();
+}
+
+
+bool GifDecoder::open(const char *filename)
+{
+  close();
+
+  _file = fopen(filename, "rb");
+  if (_file == NULL)
+  {
+    perror(filename);
+    return false;
+  }
+
+  char signature[6];
+
+#define EXIT_WITH_MSG(m) { fprintf(stderr, "%s: %s\n", filename, m); \
+     close(); return false; }
+
+  if (fread(signature, 1, 6, _file) != 6 ||
+      (memcmp(signature, "GIF87a", 6) != 0 && memcmp(signature, "GIF89a", 6) != 0))
+    EXIT_WITH_MSG("Not a GIF file.");
+
+  // Logical Screen Descriptor
+  const uint16_t width = readWord();
+  const uint16_t height = readWord();
+  const int flags = readByte();
+  _backgroundIndex = readByte();
+  readByte(); // pixel aspect ratio
+
+  if (flags < 0 || width == 0 || height == 0 || width > 4096 || height > 4096)
+    EXIT_WITH_MSG("Bad logical screen size.");
+
+  _hasGlobalTable = (flags & 0x80) != 0;
+
+  if (_hasGlobalTable && !readColorTable(_globalTable, 2 << (flags & 0x7)))
+    EXIT_WITH_MSG("Global color table too short.");
+
+#undef EXIT_WITH_MSG
+
+  _screen = new Canvas(width, height);
+  _previous = new Canvas(width, height);
+
+  return true;
+}
+
+
+void GifDecoder::close()
+{
+  if (_file) fclose(_file);
+
+  delete _screen;
+  delete _previous;
+
+  _file = NULL;
+  _screen = NULL;
+  _previous = NULL;
+
+  _hasGlobalTable = false;
+  _backgroundIndex = 0;
+  _loopCount = 0;
+
+  _delayMs = 0;
+  _transparent = -1;
+  _disposal = DisposeNone;
+
+  _frameDelayMs = 0;
+  _frameDisposal = DisposeNone;
+
+  _blockLeft = 0;
+  _blockEnd = true;
+}
+
+
+int16_t GifDecoder::width() const
+{
+  return _screen ? _screen->width() : 0;
+}
+
+
+int16_t GifDecoder::height() const
+{
+  return _screen ? _screen->height() : 0;
+}
+
+
+bool GifDecoder::nextFrame()
+{
+  if (_file == NULL) return false;
+
+  disposeFrame();
+
+  while (true)
+  {
+    const int block = readByte();
+
+    if (block == 0x21)  // Extension
+    {
+      if (!readExtension()) return false;
+    }
+    else if (block == 0x2C)  // Image Descriptor
+    {
+      return readImage();
+    }
+    else  // Trailer (0x3B), end of file or garbage
+    {
+      return false;
+    }
+  }
+}
+
+
+bool GifDecoder::readColorTable(Color *table, int size)
+{
+  return fread(table, sizeof(Color), size, _file) == (size_t)size;
+}
+
+
+bool GifDecoder::readExtension()
+{
+  const int label = readByte();
+
+  _blockLeft = 0;
+  _blockEnd = false;
+
+  if (label == 0xF9)  // Graphic Control Extension
+  {
+    const int flags = readDataByte();
+    const int delay = readDataByte() | (readDataByte() << 8);
+    const int transparent = readDataByte();
+
+    _disposal = (flags >> 2) & 0x7;
+    _transparent = (flags & 0x1) ? transparent : -1;
+
+    // Like browsers, treat very short delays as 100ms.
+    _delayMs = (delay <= 1) ? 100 : delay * 10;
+  }
+  else if (label == 0xFF)  // Application Extension
+  {
+    char id[11];
+
+    for (int i = 0; i < 11; i++)
+    {
+      id[i] = readDataByte();
+    }
+
+    // The loop count is in the sub-block after the identifier.
+    if (memcmp(id, "NETSCAPE2.0", 11) == 0 && readDataByte() == 1)
+    {
+      _loopCount = readDataByte() | (readDataByte() << 8);
+    }
+  }
+
+  skipData();
+
+  return !feof(_file);
+}
+
+
+bool GifDecoder::readImage()
+{
+  // Up to 65535, which doesn't fit in a Rect.
+  const int left = readWord();
+  const int top = readWord();
+  const int width = readWord();
+  const int height = readWord();
+
+  const int flags = readByte();
+  if (flags < 0) return false;
+
+  Color localTable[256];
+  const Color *table = _globalTable;
+
+  if (flags & 0x80)
+  {
+    if (!readColorTable(localTable, 2 << (flags & 0x7))) return false;
+    table = localTable;
+  }
+
+  if (_disposal == DisposePrevious)
+  {
+    for (int y = 0; y < _screen->height(); y++)
+    {
+      memcpy(_previous->row(y), _screen->row(y), _screen->width() * sizeof(Color));
+    }
+  }
+
+  const bool ok = decodePixels(left, top, width, height, table,
+                               (flags & 0x40) != 0);
+
+  // The part of the image on the logical screen, which is what disposing
+  // of it clears.
+  const int right = std::min(left + width, (int)_screen->width());
+  const int bottom = std::min(top + height, (int)_screen->height());
+
+  Rect rect;
+  rect.x = std::min(left, (int)_screen->width());
+  rect.y = std::min(top, (int)_screen->height());
+  rect.w = std::max(right - rect.x, 0);
+  rect.h = std::max(bottom - rect.y, 0);
+
+  // Remember how to dispose of this frame, and reset the Graphic Control
+  // Extension, which only applies to one image.
+  _frameDelayMs = _delayMs ? _delayMs : 100;
+  _frameDisposal = _disposal;
+  _frameRect = rect;
+
+  _delayMs = 0;
+  _transparent = -1;
+  _disposal = DisposeNone;
+
+  return ok;
+}
+
+
+void GifDecoder::disposeFrame()
+{
+  if (_frameDisposal == DisposeBackground)
+  {
+    Color background = { 0, 0, 0 };
+    if (_hasGlobalTable) background = _globalTable[_backgroundIndex];
+
+    for (int y = _frameRect.y; y < _frameRect.y + _frameRect.h; y++)
+    {
+      if (y >= _screen->height()) break;
+
+      Color *row = _screen->row(y);
+
+      for (int x = _frameRect.x; x < _frameRect.x + _frameRect.w && x < _screen->width(); x++)
+      {
+        row[x] = background;
+      }
+    }
+  }
+  else if (_frameDisposal == DisposePrevious)
+  {
+    for (int y = 0; y < _screen->height(); y++)
+    {
+      memcpy(_screen->row(y), _previous->row(y), _screen->width() * sizeof(Color));
+    }
+  }
+
+  _frameDisposal = DisposeNone;
+}
+
+
+bool GifDecoder::decodePixels(int imageX, int imageY, int width, int height,
+                              const Color *table, bool interlaced)
+{
+  const int minCodeSize = readByte();
+  if (minCodeSize < 1 || minCodeSize > 11) return false;
+
+  _blockLeft = 0;
+  _blockEnd = false;
+
+  // Rows of an interlaced image come in four passes.
+  static const int PassStart[4] = { 0, 4, 2, 1 };
+  static const int PassStep[4]  = { 8, 8, 4, 2 };
+  int pass = 0;
+
+  int x = 0, y = 0;
+  const long pixelCount = (long)width * height;
+  long pixel = 0;
+
+  const int clearCode = 1 << minCodeSize;
+  const int endCode = clearCode + 1;
+
+  int codeSize = minCodeSize + 1;
+  int nextCode = clearCode + 2;
+  int oldCode = -1;
+  uint8_t first = 0;
+
+  uint32_t bits = 0;
+  int bitCount = 0;
+
+  for (int i = 0; i < clearCode; i++)
+  {
+    _prefix[i] = 0;
+    _suffix[i] = i;
+  }
+
+  while (pixel < pixelCount)
+  {
+    while (bitCount < codeSize)
+    {
+      const int b = readDataByte();
+      if (b < 0) break;
+
+      bits |= (uint32_t)b << bitCount;
+      bitCount += 8;
+    }
+
+    if (bitCount < codeSize) break;  // Ran out of data
+
+    int code = bits & ((1 << codeSize) - 1);
+    bits >>= codeSize;
+    bitCount -= codeSize;
+
+    if (code == clearCode)
+    {
+      codeSize = minCodeSize + 1;
+      nextCode = clearCode + 2;
+      oldCode = -1;
+      continue;
+    }
+
+    if (code == endCode) break;
+
+    int top = 0;
+
+    if (oldCode < 0)
+    {
+      if (code >= clearCode) break;  // Broken data
+
+      _stack[top++] = code;
+      first = code;
+    }
+    else
+    {
+      const int inCode = code;
+
+      if (code > nextCode) break;  // Broken data
+
+      if (code == nextCode)
+      {
+        _stack[top++] = first;
+        code = oldCode;
+      }
+
+      while (code >= clearCode)
+      {
+        _stack[top++] = _suffix[code];
+        code = _prefix[code];
+      }
+
+      first = code;
+      _stack[top++] = first;
+
+      if (nextCode < MaxCodes)
+      {
+        _prefix[nextCode] = oldCode;
+        _suffix[nextCode] = first;
+        nextCode++;
+
+        if (nextCode == (1 << codeSize) && codeSize < 12) codeSize++;
+      }
+
+      code = inCode;
+    }
+
+    oldCode = code;
+
+    // The stack holds the indexes of the string backwards.
+    while (top > 0 && pixel < pixelCount)
+    {
+      const uint8_t index = _stack[--top];
+      const int sx = imageX + x;
+      const int sy = imageY + y;
+
+      if (index != _transparent && sx >= 0 && sy >= 0 &&
+          sx < _screen->width() && sy < _screen->height())
+      {
+        _screen->row(sy)[sx] = table[index];
+      }
+
+      pixel++;
+
+      if (++x == width)
+      {
+        x = 0;
+
+        if (!interlaced)
+        {
+          y++;
+        }
+        else
+        {
+          y += PassStep[pass];
+
+          while (y >= height && pass < 3)
+          {
+            pass++;
+            y = PassStart[pass];
+          }
+        }
+      }
+    }
+  }
+
+  skipData();
+
+  return !feof(_file);
+}
+
+
+int GifDecoder::readDataByte()
+{
+  if (_blockLeft == 0)
+  {
+    if (_blockEnd) return -1;
+
+    const int size = readByte();
+
+    if (size <= 0)  // Block terminator or end of file
+    {
+      _blockEnd = true;
+      return -1;
+    }
+
+    _blockLeft = size;
+  }
+
+  _blockLeft--;
+  return readByte();
+}
+
+
+void GifDecoder::skipData()
+{
+  while (readDataByte() >= 0)
+  {
+    ;
+  }
+}
+
+
+uint16_t GifDecoder::readWord()
+{
+  const int lo = readByte();
+  const int hi = readByte();
+
+  return (lo & 0xff) | ((hi & 0xff) << 8);
+}
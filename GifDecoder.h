@@ -0,0 +1,115 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Streaming decoder for (animated) GIF images.
+//
+// The file is read one block at a time, so only the logical screen (and a
+// copy of it for frames that restore the previous image) is kept in memory.
+// Each call to nextFrame() decodes one image onto the screen, applying the
+// disposal method of the frame before it, transparency and interlacing.
+
+#ifndef RPI_GIFDECODER_H
+#define RPI_GIFDECODER_H
+
+#include "Canvas.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+
+class GifDecoder
+{
+public:
+
+  GifDecoder();
+  ~GifDecoder();
+
+  // Open a GIF file and read its header and global color table.
+  bool open(const char *filename);
+
+  void close();
+
+  // Size of the logical screen (0 if no file is open).
+  int16_t width() const;
+  int16_t height() const;
+
+  // Number of times the animation should be played after the first time
+  // (0: forever), from the NETSCAPE2.0 extension. Defaults to 0.
+  inline uint16_t loopCount() const { return _loopCount; }
+
+  // Decode the next frame onto the screen. Returns false after the last
+  // frame or if the file is broken.
+  bool nextFrame();
+
+  // The logical screen after the last decoded frame.
+  inline const Canvas &screen() const { return *_screen; }
+
+  // How long the last decoded frame should be shown, in milliseconds.
+  inline int delayMs() const { return _frameDelayMs; }
+
+
+private:
+
+  // Disposal methods from the Graphic Control Extension.
+  enum Disposal {
+    DisposeNone = 0,
+    DisposeKeep = 1,
+    DisposeBackground = 2,
+    DisposePrevious = 3
+  };
+
+  bool readColorTable(Color *table, int size);
+  bool readExtension();
+  bool readImage();
+  void disposeFrame();
+
+  // Read the LZW compressed pixels of an image and draw the ones on the
+  // logical screen.
+  bool decodePixels(int imageX, int imageY, int width, int height,
+                    const Color *table, bool interlaced);
+
+  // Read the next byte of the current data sub-blocks, -1 after the last.
+  int readDataByte();
+
+  // Skip the rest of the current data sub-blocks.
+  void skipData();
+
+  inline int readByte() { return fgetc(_file); }
+  uint16_t readWord();
+
+  FILE *_file;
+
+  Canvas *_screen;
+  Canvas *_previous;  // Screen before a frame with DisposePrevious
+
+  Color _globalTable[256];
+  bool _hasGlobalTable;
+  uint8_t _backgroundIndex;
+  uint16_t _loopCount;
+
+  // From the Graphic Control Extension for the next image.
+  int _delayMs;
+  int _transparent;  // Transparent color index, -1 if none
+  int _disposal;
+
+  // The last decoded frame, disposed of before decoding the next.
+  int _frameDelayMs;
+  int _frameDisposal;
+  Rect _frameRect;
+
+  // State of the data sub-blocks being read.
+  int _blockLeft;
+  bool _blockEnd;
+
+  // LZW codes are at most 12 bits.
+  static const int MaxCodes = 4096;
+
+  // The LZW string table: each code is a prefix code plus one last index.
+  // Kept per decoder, so decoders on different threads don't share it.
+  uint16_t _prefix[MaxCodes];
+  uint8_t _suffix[MaxCodes];
+  uint8_t _stack[MaxCodes + 1];
+};
+
+#endif
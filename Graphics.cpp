@@ -0,0 +1,1448 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Base class for anything that can be drawn on: the RGB Matrix itself
+// and offscreen Canvases.
+
+#include "Graphics.h"
+#include "ColorSpace.h"
+#include "Path.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#define _USE_MATH_DEFINES
+
+
+Graphics::Graphics(int16_t width, int16_t height)
+  : _width(width), _height(height)
+{
+  //Initialize text members
+  _textCursorX = 0;
+  _textCursorY = 0;
+  Color white;
+  white.red = 255;
+  white.green = 255;
+  white.blue = 255;
+  _fontColor = white;
+  _fontSize = 1;
+  _fontWidth = 3;
+  _fontHeight = 5;
+  _wordWrap = true;
+
+  resetClipRect();
+}
+
+
+void Graphics::setClipRect(const Rect &clip)
+{
+  // Intersect with the surface, in int as the sums can overflow int16_t.
+  const int right = std::min<int>(clip.x + clip.w, _width);
+  const int bottom = std::min<int>(clip.y + clip.h, _height);
+
+  _clip.x = std::max<int>(clip.x, 0);
+  _clip.y = std::max<int>(clip.y, 0);
+  _clip.w = std::max<int>(right - _clip.x, 0);
+  _clip.h = std::max<int>(bottom - _clip.y, 0);
+}
+
+
+void Graphics::resetClipRect()
+{
+  _clip.x = 0;
+  _clip.y = 0;
+  _clip.w = _width;
+  _clip.h = _height;
+}
+
+
+// Outcodes of Cohen-Sutherland clipping: where a point is relative to the
+// clip rectangle.
+enum { ClipLeft = 1, ClipRight = 2, ClipTop = 4, ClipBottom = 8 };
+
+static int outCode(int32_t x, int32_t y, const Rect &clip)
+{
+  int code = 0;
+
+  if (x < clip.x) code |= ClipLeft;
+  else if (x >= clip.x + clip.w) code |= ClipRight;
+
+  if (y < clip.y) code |= ClipTop;
+  else if (y >= clip.y + clip.h) code |= ClipBottom;
+
+  return code;
+}
+
+
+void Graphics::blendPixel(int16_t x, int16_t y, Color color, uint8_t alpha)
+{
+  if (alpha == 0) return;
+
+  if (alpha < 255)
+  {
+    color.red = div255(color.red * alpha);
+    color.green = div255(color.green * alpha);
+    color.blue = div255(color.blue * alpha);
+  }
+
+  drawPixel(x, y, color);
+}
+
+
+// Bresenham's Line Algorithm
+void Graphics::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                         Color color)
+{
+  // Straight lines are spans, which are clipped by themselves.
+  if (y0 == y1)
+  {
+    drawHLine(std::min(x0, x1), y0, abs(x1 - x0) + 1, color);
+    return;
+  }
+
+  if (x0 == x1)
+  {
+    drawVLine(x0, std::min(y0, y1), abs(y1 - y0) + 1, color);
+    return;
+  }
+
+  // Lines wholly beyond one edge of the clip rectangle are skipped.
+  if (outCode(x0, y0, _clip) & outCode(x1, y1, _clip)) return;
+
+  bool steep = abs(y1 - y0) > abs(x1 - x0);
+
+  if (steep)
+  {
+    std::swap(x0, y0);
+    std::swap(x1, y1);
+  }
+
+  if (x0 > x1)
+  {
+    std::swap(x0, x1);
+    std::swap(y0, y1);
+  }
+
+  const int32_t dx = x1 - x0;
+  const int32_t dy = abs(y1 - y0);
+  const int32_t half = dx / 2;
+  int16_t ystep;
+
+  if (y0 < y1)
+  {
+    ystep = 1;
+  }
+  else
+  {
+    ystep = -1;
+  }
+
+  // The clip rectangle along the major (x) and minor (y) axis.
+  const int32_t minX = steep ? _clip.y : _clip.x;
+  const int32_t maxX = minX + (steep ? _clip.h : _clip.w) - 1;
+  const int32_t minY = steep ? _clip.x : _clip.y;
+  const int32_t maxY = minY + (steep ? _clip.w : _clip.h) - 1;
+
+  // Pixel i of the line is at (x0 + i, y0 + ystep * k), after
+  // k = ceil((i * dy - half) / dx) minor steps. Work out which pixels are
+  // inside the clip rectangle on both axes, and only visit those. They are
+  // the same pixels the line would have without clipping.
+  int64_t first = std::max<int64_t>(0, minX - x0);
+  int64_t last = std::min<int64_t>(dx, maxX - x0);
+
+  const int64_t minSteps = (ystep > 0) ? minY - y0 : y0 - maxY;
+  const int64_t maxSteps = (ystep > 0) ? maxY - y0 : y0 - minY;
+
+  if (maxSteps < 0) return;
+
+  if (minSteps > 0)
+  {
+    first = std::max<int64_t>(first, ((minSteps - 1) * dx + half) / dy + 1);
+  }
+
+  last = std::min<int64_t>(last, (maxSteps * dx + half) / dy);
+
+  if (first > last) return;
+
+  // Start Bresenham's loop at the first visible pixel.
+  const int64_t steps = (first * dy - half + dx - 1) / dx;
+
+  int16_t x = x0 + first;
+  int16_t y = y0 + ystep * steps;
+  int32_t err = half - first * dy + steps * dx;
+
+  for (const int16_t end = x0 + last; x <= end; x++)
+  {
+    if (steep)
+    {
+      drawPixel(y, x, color);
+    }
+    else
+    {
+      drawPixel(x, y, color);
+    }
+
+    err -= dy;
+
+    if (err < 0)
+    {
+      y += ystep;
+      err += dx;
+    }
+  }
+}
+
+
+// Blend a pixel of a line, which is mirrored on the diagonal when steep.
+static inline void blendLinePixel(Graphics &g, bool steep, int16_t x, int16_t y,
+                                  Color color, uint8_t alpha)
+{
+  if (steep)
+  {
+    g.blendPixel(y, x, color, alpha);
+  }
+  else
+  {
+    g.blendPixel(x, y, color, alpha);
+  }
+}
+
+
+// Wu's Line Algorithm: the line passes between two pixels of each column,
+// which share its color by how close they are to it.
+void Graphics::drawLineAA(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                          Color color)
+{
+  if (outCode(x0, y0, _clip) & outCode(x1, y1, _clip)) return;
+
+  bool steep = abs(y1 - y0) > abs(x1 - x0);
+
+  if (steep)
+  {
+    std::swap(x0, y0);
+    std::swap(x1, y1);
+  }
+
+  if (x0 > x1)
+  {
+    std::swap(x0, x1);
+    std::swap(y0, y1);
+  }
+
+  // The ends are on whole pixels.
+  blendLinePixel(*this, steep, x0, y0, color, 255);
+
+  const int32_t dx = x1 - x0;
+  if (dx == 0) return;
+
+  blendLinePixel(*this, steep, x1, y1, color, 255);
+
+  // Only the columns inside the clip rectangle are visited.
+  const int32_t minX = steep ? _clip.y : _clip.x;
+  const int32_t maxX = minX + (steep ? _clip.h : _clip.w) - 1;
+  const int32_t first = std::max<int32_t>(x0 + 1, minX);
+  const int32_t last = std::min<int32_t>(x1 - 1, maxX);
+
+  // y of the line in 1/65536ths of a pixel.
+  const int32_t gradient = ((int64_t)(y1 - y0) * 65536) / dx;
+  int32_t y = (int32_t)y0 * 65536 + (int64_t)gradient * (first - x0);
+
+  for (int32_t x = first; x <= last; x++)
+  {
+    const uint8_t below = (y >> 8) & 0xff;
+
+    blendLinePixel(*this, steep, x, y >> 16, color, 255 - below);
+    blendLinePixel(*this, steep, x, (y >> 16) + 1, color, below);
+
+    y += gradient;
+  }
+}
+
+
+// Draw a vertical line
+void Graphics::drawVLine(int16_t x, int16_t y, int16_t h, Color color)
+{
+  if (x < _clip.x || x >= _clip.x + _clip.w) return;
+
+  // The ends in int, as y + h can overflow int16_t.
+  const int top = std::max<int>(y, _clip.y);
+  const int bottom = std::min<int>(y + h, _clip.y + _clip.h);
+
+  for (int j = top; j < bottom; j++)
+  {
+    drawPixel(x, j, color);
+  }
+}
+
+
+// Draw a horizontal line
+void Graphics::drawHLine(int16_t x, int16_t y, int16_t w, Color color)
+{
+  if (!clipSpan(x, y, w)) return;
+
+  for (int16_t i = 0; i < w; i++)
+  {
+    drawPixel(x + i, y, color);
+  }
+}
+
+
+// Draw the outline of a rectangle (no fill)
+void Graphics::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, Color color)
+{
+  drawHLine(x, y, w, color);
+  drawHLine(x, y + h - 1, w, color);
+  drawVLine(x, y, h, color);
+  drawVLine(x + w - 1, y, h, color);
+}
+
+
+void Graphics::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, Color color)
+{
+  // Only the rows inside the clip rectangle, in int as y + h can overflow
+  // int16_t.
+  const int top = std::max<int>(y, _clip.y);
+  const int bottom = std::min<int>(y + h, _clip.y + _clip.h);
+
+  for (int j = top; j < bottom; j++)
+  {
+    drawHLine(x, j, w, color);
+  }
+}
+
+
+void Graphics::fillScreen(Color color)
+{
+  fillRect(0, 0, _width, _height, color);
+}
+
+
+// Draw a rounded rectangle with radius r.
+void Graphics::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r,
+                              Color color)
+{
+  drawHLine(x + r    , y        , w - 2 * r, color);
+  drawHLine(x + r    , y + h - 1, w - 2 * r, color);
+  drawVLine(x        , y + r    , h - 2 * r, color);
+  drawVLine(x + w - 1, y + r    , h - 2 * r, color);
+
+  drawCircleQuadrant(x + r        , y + r        , r, 1, color);
+  drawCircleQuadrant(x + w - r - 1, y + r        , r, 2, color);
+  drawCircleQuadrant(x + w - r - 1, y + h - r - 1, r, 4, color);
+  drawCircleQuadrant(x + r        , y + h - r - 1, r, 8, color);
+}
+
+
+void Graphics::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r,
+                              Color color)
+{
+  fillRect(x, y + r, w, h - 2 * r, color);
+  fillRoundEnds(x + r, x + w - r - 1, y + r, y + h - r - 1, r, color);
+}
+
+
+// Draw the outline of a cirle (no fill) - Midpoint Circle Algorithm
+void Graphics::drawCircle(int16_t x, int16_t y, int16_t r, Color color)
+{
+  if (!overlapsClip(x - r, y - r, 2 * r + 1, 2 * r + 1)) return;
+
+  int16_t f = 1 - r;
+  int16_t ddFx = 1;
+  int16_t ddFy = -2 * r;
+  int16_t x1 = 0;
+  int16_t y1 = r;
+
+  drawPixel(x, y + r, color);
+  drawPixel(x, y - r, color);
+  drawPixel(x + r, y, color);
+  drawPixel(x - r, y, color);
+
+  while (x1 < y1)
+  {
+    if (f >= 0)
+    {
+      y1--;
+      ddFy += 2;
+      f += ddFy;
+    }
+
+    x1++;
+    ddFx += 2;
+    f += ddFx;
+
+    drawPixel(x + x1, y + y1, color);
+    drawPixel(x - x1, y + y1, color);
+    drawPixel(x + x1, y - y1, color);
+    drawPixel(x - x1, y - y1, color);
+    drawPixel(x + y1, y + x1, color);
+    drawPixel(x - y1, y + x1, color);
+    drawPixel(x + y1, y - x1, color);
+    drawPixel(x - y1, y - x1, color);
+  }
+}
+
+void Graphics::drawCircleAA(int16_t x, int16_t y, int16_t r, Color color)
+{
+  drawArcAA(x, y, r, 0, 360, color);
+}
+
+// Draw one of the four quadrants of a circle.
+void Graphics::drawCircleQuadrant(int16_t x, int16_t y, int16_t r, uint8_t quadrant,
+                                   Color color)
+{
+  if (!overlapsClip(x - r, y - r, 2 * r + 1, 2 * r + 1)) return;
+
+  int16_t f = 1 - r;
+  int16_t ddFx = 1;
+  int16_t ddFy = -2 * r;
+  int16_t x1 = 0;
+  int16_t y1 = r;
+
+  while (x1 < y1)
+  {
+    if (f >= 0)
+    {
+      y1--;
+      ddFy += 2;
+      f += ddFy;
+    }
+
+    x1++;
+    ddFx += 2;
+    f += ddFx;
+
+    //Upper Left
+    if (quadrant & 0x1)
+    {
+      drawPixel(x - y1, y - x1, color);
+      drawPixel(x - x1, y - y1, color);
+    }
+
+    //Upper Right
+    if (quadrant & 0x2)
+    {
+      drawPixel(x + x1, y - y1, color);
+      drawPixel(x + y1, y - x1, color);
+    }
+
+    //Lower Right
+    if (quadrant & 0x4)
+    {
+      drawPixel(x + x1, y + y1, color);
+      drawPixel(x + y1, y + x1, color);
+    }
+
+    //Lower Left
+    if (quadrant & 0x8)
+    {
+      drawPixel(x - y1, y + x1, color);
+      drawPixel(x - x1, y + y1, color);
+    }
+  }
+}
+
+
+void Graphics::fillCircle(int16_t x, int16_t y, int16_t r, Color color)
+{
+  drawHLine(x - r, y, 2 * r + 1, color);
+  fillRoundEnds(x, x, y, y, r, color);
+}
+
+
+// Fill the rounded ends of a shape whose rows from top to bottom span from
+// left to right: r rows above and below, each narrowed by a quarter of the
+// Midpoint Circle at either side. The rows are drawn as spans, which the
+// matrix writes straight into the bit planes.
+void Graphics::fillRoundEnds(int16_t left, int16_t right,
+                             int16_t top, int16_t bottom, int16_t r,
+                             Color color)
+{
+  if (!overlapsClip(left - r, top - r, right - left + 2 * r + 1,
+                    bottom - top + 2 * r + 1)) return;
+
+  int16_t f = 1 - r;
+  int16_t ddFx = 1;
+  int16_t ddFy = -2 * r;
+  int16_t x1 = 0;
+  int16_t y1 = r;
+
+  while (x1 < y1)
+  {
+    if (f >= 0)
+    {
+      // The rows y1 away are as wide as they get.
+      drawHLine(left - x1, top - y1, right - left + 2 * x1 + 1, color);
+      drawHLine(left - x1, bottom + y1, right - left + 2 * x1 + 1, color);
+
+      y1--;
+      ddFy += 2;
+      f += ddFy;
+    }
+
+    x1++;
+    ddFx += 2;
+    f += ddFx;
+
+    drawHLine(left - y1, top - x1, right - left + 2 * y1 + 1, color);
+    drawHLine(left - y1, bottom + x1, right - left + 2 * y1 + 1, color);
+  }
+}
+
+
+void Graphics::fillCircleHalf(int16_t x, int16_t y, int16_t r,
+                               uint8_t half, int16_t stretch,
+                               Color color)
+{
+  if (!overlapsClip(x - r, y - r, 2 * r + 1, 2 * r + 1 + stretch)) return;
+
+  int16_t f = 1 - r;
+  int16_t ddFx = 1;
+  int16_t ddFy = -2 * r;
+  int16_t x1 = 0;
+  int16_t y1 = r;
+
+  while (x1 < y1)
+  {
+    if (f >= 0)
+    {
+      y1--;
+      ddFy += 2;
+      f += ddFy;
+    }
+
+    x1++;
+    ddFx += 2;
+    f += ddFx;
+
+    //Left
+    if (half & 0x1)
+    {
+      drawVLine(x - x1, y - y1, 2 * y1 + 1 + stretch, color);
+      drawVLine(x - y1, y - x1, 2 * x1 + 1 + stretch, color);
+    }
+
+    //Right
+    if (half & 0x2)
+    {
+      drawVLine(x + x1, y - y1, 2 * y1 + 1 + stretch, color);
+      drawVLine(x + y1, y - x1, 2 * x1 + 1 + stretch, color);
+   }
+  }
+}
+
+// The directions of the ends of an arc, in 1/4096ths, to tell which points
+// are inside it from the signs of cross products.
+struct ArcEnds
+{
+  int32_t startX, startY;
+  int32_t endX, endY;
+  bool full;  // The whole circle
+  bool wide;  // More than half of it
+};
+
+
+// Returns false if the arc is empty.
+static bool arcEnds(float startAngle, float endAngle, ArcEnds *ends)
+{
+  const float radiansPerDegree = M_PI / 180;
+  float sweep = endAngle - startAngle;
+
+  ends->full = sweep >= 360;
+
+  sweep = fmod(sweep, 360);
+  if (sweep < 0) sweep += 360;
+
+  if (sweep == 0 && !ends->full) return false;
+
+  ends->wide = sweep > 180;
+  ends->startX = lround(4096 * cos(startAngle * radiansPerDegree));
+  ends->startY = lround(4096 * sin(startAngle * radiansPerDegree));
+  ends->endX = lround(4096 * cos(endAngle * radiansPerDegree));
+  ends->endY = lround(4096 * sin(endAngle * radiansPerDegree));
+
+  return true;
+}
+
+
+// Whether the offset (dx, dy) from the center is inside the arc.
+static inline bool inArc(const ArcEnds &ends, int32_t dx, int32_t dy)
+{
+  if (ends.full) return true;
+
+  const bool afterStart = ends.startX * dy - ends.startY * dx >= 0;
+  const bool beforeEnd = dx * ends.endY - dy * ends.endX >= 0;
+
+  return ends.wide ? (afterStart || beforeEnd) : (afterStart && beforeEnd);
+}
+
+
+// Blend the points of the arc at (a, b) from the center in all eight
+// octants, with a <= b. Mirrors that land on the same pixel (on an axis or
+// a diagonal) are only drawn once.
+static void blendOctants(Graphics &g, int16_t x, int16_t y,
+                         int16_t a, int16_t b, const ArcEnds &ends,
+                         Color color, uint8_t alpha)
+{
+  if (alpha == 0) return;
+
+  const int mirrors = (a == b) ? 1 : 2;
+
+  for (int m = 0; m < mirrors; m++)
+  {
+    const int16_t u = m ? b : a;
+    const int16_t v = m ? a : b;
+
+    for (int quadrant = 0; quadrant < 4; quadrant++)
+    {
+      if ((quadrant & 1) && u == 0) continue;
+      if ((quadrant & 2) && v == 0) continue;
+
+      const int16_t dx = (quadrant & 1) ? -u : u;
+      const int16_t dy = (quadrant & 2) ? -v : v;
+
+      if (inArc(ends, dx, dy))
+      {
+        g.blendPixel(x + dx, y + dy, color, alpha);
+      }
+    }
+  }
+}
+
+
+// Draw an Arc: the pixels of the Midpoint Circle that are between the
+// angles.
+void Graphics::drawArc(int16_t x, int16_t y, int16_t r,
+                       float startAngle, float endAngle,
+                       Color color)
+{
+  if (r < 0 || !overlapsClip(x - r, y - r, 2 * r + 1, 2 * r + 1)) return;
+
+  ArcEnds ends;
+  if (!arcEnds(startAngle, endAngle, &ends)) return;
+
+  int16_t f = 1 - r;
+  int16_t ddFx = 1;
+  int16_t ddFy = -2 * r;
+  int16_t x1 = 0;
+  int16_t y1 = r;
+
+  blendOctants(*this, x, y, x1, y1, ends, color, 255);
+
+  while (x1 < y1)
+  {
+    if (f >= 0)
+    {
+      y1--;
+      ddFy += 2;
+      f += ddFy;
+    }
+
+    x1++;
+    ddFx += 2;
+    f += ddFx;
+
+    // Past the diagonal, the points are mirrors of ones already drawn.
+    if (x1 > y1) break;
+
+    blendOctants(*this, x, y, x1, y1, ends, color, 255);
+  }
+}
+
+
+// Anti-aliased arc (Wu's algorithm for circles): in each column of an
+// octant, the circle passes between two pixels, which share its color by
+// how close they are to it.
+void Graphics::drawArcAA(int16_t x, int16_t y, int16_t r,
+                         float startAngle, float endAngle,
+                         Color color)
+{
+  if (r < 0 || !overlapsClip(x - r - 1, y - r - 1, 2 * r + 3, 2 * r + 3)) return;
+
+  ArcEnds ends;
+  if (!arcEnds(startAngle, endAngle, &ends)) return;
+
+  const int32_t rr = (int32_t)r * r;
+  int32_t b = r;
+
+  for (int32_t a = 0; a <= b; a++)
+  {
+    // b is the whole part of the circle's height in this column. The
+    // fraction in 1/256ths is interpolated between the squares of b and
+    // b + 1, which is exact to well within 1/256th of a pixel.
+    const int32_t bb = rr - a * a;
+    while (b * b > bb) b--;
+
+    if (a > b) break;
+
+    const int32_t beyond = ((bb - b * b) << 8) / (2 * b + 1);
+
+    blendOctants(*this, x, y, a, b, ends, color, 255 - beyond);
+    blendOctants(*this, x, y, a, b + 1, ends, color, beyond);
+  }
+}
+
+
+// A point on the circle at angle (in degrees), rounded to the nearest pixel.
+static void circlePoint(int16_t x, int16_t y, int16_t r, float angle,
+                        int16_t *px, int16_t *py)
+{
+  const float radians = angle * M_PI / 180;
+
+  *px = x + lround(r * cos(radians));
+  *py = y + lround(r * sin(radians));
+}
+
+
+// Draw the outline of a wedge.
+void Graphics::drawWedge(int16_t x, int16_t y, int16_t r,
+                          float startAngle, float endAngle,
+                          Color color)
+{
+  drawRing(x, y, 0, r, startAngle, endAngle, color);
+}
+
+
+void Graphics::drawWedgeAA(int16_t x, int16_t y, int16_t r,
+                           float startAngle, float endAngle,
+                           Color color)
+{
+  int16_t startX, startY, endX, endY;
+
+  circlePoint(x, y, r, startAngle, &startX, &startY);
+  circlePoint(x, y, r, endAngle, &endX, &endY);
+
+  drawLineAA(x, y, startX, startY, color);
+  drawArcAA(x, y, r, startAngle, endAngle, color);
+  drawLineAA(endX, endY, x, y, color);
+}
+
+
+void Graphics::fillWedge(int16_t x, int16_t y, int16_t r,
+                         float startAngle, float endAngle,
+                         Color color)
+{
+  fillRing(x, y, 0, r, startAngle, endAngle, color);
+}
+
+
+void Graphics::drawRing(int16_t x, int16_t y, int16_t innerR, int16_t outerR,
+                        float startAngle, float endAngle,
+                        Color color)
+{
+  // A whole ring has no ends.
+  if (endAngle - startAngle < 360)
+  {
+    int16_t innerX, innerY, outerX, outerY;
+
+    circlePoint(x, y, innerR, startAngle, &innerX, &innerY);
+    circlePoint(x, y, outerR, startAngle, &outerX, &outerY);
+    drawLine(innerX, innerY, outerX, outerY, color);
+
+    circlePoint(x, y, innerR, endAngle, &innerX, &innerY);
+    circlePoint(x, y, outerR, endAngle, &outerX, &outerY);
+    drawLine(outerX, outerY, innerX, innerY, color);
+  }
+
+  drawArc(x, y, outerR, startAngle, endAngle, color);
+  drawArc(x, y, innerR, startAngle, endAngle, color);
+}
+
+
+// A range of columns of a row, lo to hi. It is empty if lo > hi.
+struct Columns
+{
+  int32_t lo, hi;
+};
+
+// Further than any column.
+static const int32_t Unbounded = 1 << 20;
+
+
+static inline Columns overlap(const Columns &a, const Columns &b)
+{
+  Columns c = { std::max(a.lo, b.lo), std::min(a.hi, b.hi) };
+  return c;
+}
+
+
+// The columns that are not in c, which is a half line, all or none.
+static inline Columns notIn(const Columns &c)
+{
+  Columns all = { -Unbounded, Unbounded };
+  Columns none = { 1, 0 };
+
+  if (c.lo > c.hi) return all;
+  if (c.lo <= -Unbounded && c.hi >= Unbounded) return none;
+
+  if (c.lo <= -Unbounded)
+  {
+    Columns right = { c.hi + 1, Unbounded };
+    return right;
+  }
+
+  Columns left = { -Unbounded, c.lo - 1 };
+  return left;
+}
+
+
+// The columns dx of row dy (both from the center) on one side of the line
+// through the center in direction (dirX, dirY): where
+// side * (dirX * dy - dirY * dx) >= 0. This is the same test inArc() makes.
+static Columns sideColumns(int32_t dirX, int32_t dirY, int side, int32_t dy)
+{
+  const int32_t c = side * dirX * dy;
+  const int32_t k = side * dirY;
+
+  Columns columns = { -Unbounded, Unbounded };
+
+  if (k > 0)
+  {
+    columns.hi = floorDiv(c, k);
+  }
+  else if (k < 0)
+  {
+    columns.lo = -floorDiv(-c, k);
+  }
+  else if (c < 0)
+  {
+    columns.lo = 1;
+    columns.hi = 0;
+  }
+
+  return columns;
+}
+
+
+// The widest and narrowest column of the Midpoint Circle of radius r (as
+// drawn by drawCircle() and drawArc()) in each row from the center, 0 to r.
+static void circleColumns(int16_t r, std::vector<int16_t> &widest,
+                          std::vector<int16_t> &narrowest)
+{
+  widest.assign(r + 1, 0);
+  narrowest.assign(r + 1, r);
+
+  int16_t f = 1 - r;
+  int16_t ddFx = 1;
+  int16_t ddFy = -2 * r;
+  int16_t x1 = 0;
+  int16_t y1 = r;
+
+  while (x1 <= y1)
+  {
+    widest[y1] = std::max(widest[y1], x1);
+    narrowest[y1] = std::min(narrowest[y1], x1);
+    widest[x1] = std::max(widest[x1], y1);
+    narrowest[x1] = std::min(narrowest[x1], y1);
+
+    if (f >= 0)
+    {
+      y1--;
+      ddFy += 2;
+      f += ddFy;
+    }
+
+    x1++;
+    ddFx += 2;
+    f += ddFx;
+  }
+}
+
+
+void Graphics::fillRing(int16_t x, int16_t y, int16_t innerR, int16_t outerR,
+                        float startAngle, float endAngle,
+                        Color color)
+{
+  if (innerR < 0) innerR = 0;
+  if (outerR < innerR) return;
+  if (!overlapsClip(x - outerR, y - outerR, 2 * outerR + 1, 2 * outerR + 1)) return;
+
+  ArcEnds ends;
+  if (!arcEnds(startAngle, endAngle, &ends)) return;
+
+  // The rows are bounded by the pixels drawArc() would draw for the
+  // circles, so an outline drawn over the ring lines up with it.
+  std::vector<int16_t> outerWidest, outerNarrowest;
+  std::vector<int16_t> innerWidest, innerNarrowest;
+
+  circleColumns(outerR, outerWidest, outerNarrowest);
+  if (innerR > 0) circleColumns(innerR, innerWidest, innerNarrowest);
+
+  const int32_t top = std::max<int32_t>(y - outerR, _clip.y);
+  const int32_t bottom = std::min<int32_t>(y + outerR, _clip.y + _clip.h - 1);
+
+  for (int32_t row = top; row <= bottom; row++)
+  {
+    const int32_t dy = row - y;
+    const int32_t distance = abs(dy);
+
+    // The row of the ring is one span, or two on either side of the hole.
+    Columns spans[2];
+    int spanCount = 1;
+
+    spans[0].lo = -outerWidest[distance];
+    spans[0].hi = outerWidest[distance];
+
+    if (innerR > 0 && distance <= innerR && innerNarrowest[distance] > 0)
+    {
+      const int32_t hole = innerNarrowest[distance] - 1;
+
+      spans[0].hi = -hole - 1;
+      spans[1].lo = hole + 1;
+      spans[1].hi = outerWidest[distance];
+      spanCount = 2;
+    }
+
+    // The columns between the angles. A segment of more than half of the
+    // ring is two half planes joined; the second leaves out the first.
+    Columns sector[2];
+    int sectorCount = 1;
+
+    if (ends.full)
+    {
+      sector[0].lo = -Unbounded;
+      sector[0].hi = Unbounded;
+    }
+    else
+    {
+      const Columns afterStart = sideColumns(ends.startX, ends.startY, 1, dy);
+      const Columns beforeEnd = sideColumns(ends.endX, ends.endY, -1, dy);
+
+      if (ends.wide)
+      {
+        sector[0] = afterStart;
+        sector[1] = overlap(beforeEnd, notIn(afterStart));
+        sectorCount = 2;
+      }
+      else
+      {
+        sector[0] = overlap(afterStart, beforeEnd);
+      }
+    }
+
+    for (int i = 0; i < spanCount; i++)
+    {
+      for (int j = 0; j < sectorCount; j++)
+      {
+        const Columns fill = overlap(spans[i], sector[j]);
+
+        if (fill.lo <= fill.hi)
+        {
+          drawHLine(x + fill.lo, row, fill.hi - fill.lo + 1, color);
+        }
+      }
+    }
+  }
+}
+
+
+void Graphics::drawTriangle(int16_t x1, int16_t y1,
+                             int16_t x2, int16_t y2,
+                             int16_t x3, int16_t y3,
+                             Color color)
+{
+  drawLine(x1, y1, x2, y2, color);
+  drawLine(x2, y2, x3, y3, color);
+  drawLine(x3, y3, x1, y1, color);
+}
+
+
+// An edge of a polygon, for filling it a row at a time (scanline with an
+// active edge table). Coordinates are in 1/Path::SubPixels of a pixel.
+struct PolygonEdge
+{
+  int32_t x0, y0;   // Top end
+  int32_t x1, y1;   // Bottom end
+  int winding;      // 1 if the outline goes down the edge, -1 if up
+
+  // Where the edge crosses the current row, q + r / (y1 - y0), exactly,
+  // and how far that moves from one row to the next.
+  int32_t q, r;
+  int32_t stepQ, stepR;
+};
+
+static const int32_t SubPixels = Path::SubPixels;
+
+
+// Add the edges of a closed contour, skipping those of no length.
+// Returns how many were added.
+static int addEdges(const Path::Vertex *vertices, int count,
+                    PolygonEdge *edges)
+{
+  int added = 0;
+
+  for (int i = 0; i < count; i++)
+  {
+    const Path::Vertex &a = vertices[i];
+    const Path::Vertex &b = vertices[(i + 1) % count];
+
+    if (a.x == b.x && a.y == b.y) continue;
+
+    PolygonEdge &e = edges[added++];
+    const bool down = a.y <= b.y;
+
+    e.x0 = down ? a.x : b.x;
+    e.y0 = down ? a.y : b.y;
+    e.x1 = down ? b.x : a.x;
+    e.y1 = down ? b.y : a.y;
+    e.winding = down ? 1 : -1;
+  }
+
+  return added;
+}
+
+
+// Start following a (not horizontal) edge at row y.
+static void startEdge(PolygonEdge &e, int32_t y)
+{
+  const int32_t dx = e.x1 - e.x0;
+  const int32_t dy = e.y1 - e.y0;
+  const int64_t n = (int64_t)e.x0 * dy + (int64_t)(y - e.y0) * dx;
+
+  e.q = floorDiv(n, (int64_t)dy);
+  e.r = n - (int64_t)e.q * dy;
+  e.stepQ = floorDiv(SubPixels * dx, dy);
+  e.stepR = SubPixels * dx - e.stepQ * dy;
+}
+
+
+static bool aboveOf(const PolygonEdge &a, const PolygonEdge &b)
+{
+  return a.y0 < b.y0;
+}
+
+
+static inline bool leftOf(const PolygonEdge *a, const PolygonEdge *b)
+{
+  if (a->q != b->q) return a->q < b->q;
+
+  return (int64_t)a->r * (b->y1 - b->y0) < (int64_t)b->r * (a->y1 - a->y0);
+}
+
+
+// Fill the inside of count edges, and the pixels on them. active needs
+// room for count edges.
+//
+// Each row is sampled through the pixel centers. The edges crossing it are
+// kept sorted left to right, and the spans where the fill rule is inside
+// are drawn from the first pixel center at or after one crossing to the
+// last at or before the next. Edges cover their rows from the top up to,
+// but not including, the bottom end, so vertices aren't counted twice;
+// bottom ends and horizontal edges right on a row are drawn separately.
+static void fillEdges(Graphics &g, PolygonEdge *edges, PolygonEdge **active,
+                      int count, Graphics::FillRule rule, Color color)
+{
+  if (count == 0) return;
+
+  std::sort(edges, edges + count, aboveOf);
+
+  int32_t bottom = edges[0].y1;
+
+  for (int i = 1; i < count; i++)
+  {
+    bottom = std::max(bottom, edges[i].y1);
+  }
+
+  const Rect &clip = g.clipRect();
+  const int32_t clipRight = clip.x + clip.w - 1;
+  const int32_t firstRow = std::max<int32_t>(-floorDiv(-edges[0].y0, SubPixels),
+                                             clip.y);
+  const int32_t lastRow = std::min<int32_t>(floorDiv(bottom, SubPixels),
+                                            clip.y + clip.h - 1);
+
+  int next = 0;
+  int activeCount = 0;
+
+  for (int32_t row = firstRow; row <= lastRow; row++)
+  {
+    const int32_t y = row * SubPixels;
+
+    // Drop the edges that ended, drawing the ends that are on this row.
+    int kept = 0;
+
+    for (int i = 0; i < activeCount; i++)
+    {
+      PolygonEdge *e = active[i];
+
+      if (e->y1 > y)
+      {
+        active[kept++] = e;
+      }
+      else if (e->y1 == y && e->x1 % SubPixels == 0)
+      {
+        g.drawHLine(e->x1 / SubPixels, row, 1, color);
+      }
+    }
+
+    activeCount = kept;
+
+    // Add the edges that start by this row.
+    for (; next < count && edges[next].y0 <= y; next++)
+    {
+      PolygonEdge &e = edges[next];
+
+      if (e.y1 > y && e.y0 != e.y1)
+      {
+        startEdge(e, y);
+        active[activeCount++] = &e;
+      }
+      else if (e.y0 == e.y1 && e.y0 == y)
+      {
+        // A horizontal edge right on this row.
+        const int32_t left = -floorDiv(-std::min(e.x0, e.x1), SubPixels);
+        const int32_t right = floorDiv(std::max(e.x0, e.x1), SubPixels);
+        const int32_t from = std::max(left, (int32_t)clip.x);
+        const int32_t to = std::min(right, clipRight);
+
+        if (from <= to) g.drawHLine(from, row, to - from + 1, color);
+      }
+      else if (e.y1 == y && e.x1 % SubPixels == 0)
+      {
+        g.drawHLine(e.x1 / SubPixels, row, 1, color);
+      }
+    }
+
+    // The edges stay nearly sorted from one row to the next, which suits an
+    // insertion sort.
+    for (int i = 1; i < activeCount; i++)
+    {
+      PolygonEdge *e = active[i];
+      int j = i;
+
+      for (; j > 0 && leftOf(e, active[j - 1]); j--)
+      {
+        active[j] = active[j - 1];
+      }
+
+      active[j] = e;
+    }
+
+    int winding = 0;
+    int32_t spanStart = 0;
+
+    for (int i = 0; i < activeCount; i++)
+    {
+      PolygonEdge *e = active[i];
+
+      const bool wasInside = (rule == Graphics::FillEvenOdd) ? (winding & 1)
+                                                             : (winding != 0);
+      winding += e->winding;
+      const bool isInside = (rule == Graphics::FillEvenOdd) ? (winding & 1)
+                                                            : (winding != 0);
+
+      if (isInside && !wasInside)
+      {
+        spanStart = -floorDiv(-(e->q + (e->r > 0 ? 1 : 0)), SubPixels);
+      }
+      else if (wasInside && !isInside)
+      {
+        const int32_t from = std::max(spanStart, (int32_t)clip.x);
+        const int32_t to = std::min(floorDiv(e->q, SubPixels), clipRight);
+
+        if (from <= to) g.drawHLine(from, row, to - from + 1, color);
+      }
+
+      // Move on to the next row.
+      const int32_t dy = e->y1 - e->y0;
+
+      e->q += e->stepQ;
+      e->r += e->stepR;
+
+      if (e->r >= dy)
+      {
+        e->q++;
+        e->r -= dy;
+      }
+    }
+  }
+}
+
+
+void Graphics::fillTriangle(int16_t x1, int16_t y1,
+                             int16_t x2, int16_t y2,
+                             int16_t x3, int16_t y3,
+                             Color color)
+{
+  Path::Vertex vertices[3];
+  PolygonEdge edges[3];
+  PolygonEdge *active[3];
+
+  vertices[0].x = x1 * Path::SubPixels;
+  vertices[0].y = y1 * Path::SubPixels;
+  vertices[1].x = x2 * Path::SubPixels;
+  vertices[1].y = y2 * Path::SubPixels;
+  vertices[2].x = x3 * Path::SubPixels;
+  vertices[2].y = y3 * Path::SubPixels;
+
+  const int count = addEdges(vertices, 3, edges);
+
+  fillEdges(*this, edges, active, count, FillNonZero, color);
+}
+
+
+void Graphics::fillPolygon(const Point *points, int count, Color color,
+                           FillRule rule)
+{
+  if (count < 2) return;
+
+  std::vector<Path::Vertex> vertices(count);
+
+  for (int i = 0; i < count; i++)
+  {
+    vertices[i].x = points[i].x * Path::SubPixels;
+    vertices[i].y = points[i].y * Path::SubPixels;
+  }
+
+  std::vector<PolygonEdge> edges(count);
+  std::vector<PolygonEdge *> active(count);
+
+  const int edgeCount = addEdges(&vertices[0], count, &edges[0]);
+
+  fillEdges(*this, &edges[0], &active[0], edgeCount, rule, color);
+}
+
+
+void Graphics::fillPath(const Path &path, Color color, FillRule rule)
+{
+  if (path.vertexCount() < 2) return;
+
+  std::vector<PolygonEdge> edges(path.vertexCount());
+  std::vector<PolygonEdge *> active(path.vertexCount());
+  int edgeCount = 0;
+
+  for (int i = 0; i < path.contourCount(); i++)
+  {
+    int count;
+    const Path::Vertex *vertices = path.contour(i, &count);
+
+    edgeCount += addEdges(vertices, count, &edges[edgeCount]);
+  }
+
+  fillEdges(*this, &edges[0], &active[0], edgeCount, rule, color);
+}
+
+
+// Special method to create a color wheel on the display.
+void Graphics::drawColorWheel()
+{
+  if (_height != _width)
+    fprintf(stderr, "Error: method drawColorWheel() only works when Height = Width.");
+  
+  float const Half = (_width - 1) / 2;
+
+  // Each row is converted from HSV at once.
+  std::vector<uint16_t> hue(_width);
+  std::vector<uint8_t> sat(_width), val(_width);
+  std::vector<Color> colors(_width);
+
+  for (int y = 0; y < _height; y++)
+  {
+    const float dy = Half - (float)y;
+
+    for (int x = 0; x < _width; x++)
+    {
+      const float dx = Half - (float)x;
+      float d = dx * dx + dy * dy;
+
+      hue[x] = 0;
+      sat[x] = 0;
+      val[x] = 0;
+
+      // In the circle...
+      if (d <= ((Half+1) * (Half+1)))
+      {
+        hue[x] = (int)((atan2(-dy, dx) + M_PI) * 1536.0 / (M_PI * 2.0)) % 1536;
+        d = sqrt(d);
+
+        if (d > Half)
+        {
+          // Do a little pseudo anti-aliasing along perimeter
+          sat[x] = 255;
+          val[x] = (int)((1.0 - (d - Half)) * 255.0 + 0.5);
+        }
+        else
+        {
+          // White at center
+          sat[x] = (int)(d / Half * 255.0 + 0.5);
+          val[x] = 255;
+        }
+      }
+    }
+
+    // Outside the circle, a value of 0 is black.
+    ColorSpace::hsv(&hue[0], &sat[0], &val[0], &colors[0], _width);
+
+    for (int x = 0; x < _width; x++)
+    {
+      drawPixel(x, y, colors[x]);
+    }
+  }
+}
+
+void Graphics::setTextCursor(int16_t x, int16_t y)
+{
+  _textCursorX = x;
+  _textCursorY = y;
+}
+
+void Graphics::setFontColor(Color color)
+{
+  _fontColor = color;
+}
+
+void Graphics::setFontSize(uint8_t size)
+{
+  _fontSize = (size >= 3) ? 3 : size; //only 3 sizes for now
+
+  if (_fontSize == 1)
+  {
+    _fontWidth = 3;
+    _fontHeight = 5;
+  }
+  else if (_fontSize == 2) //medium (4x6)
+  {
+    _fontWidth = 4;
+    _fontHeight = 6;
+  }
+  else if (_fontSize == 3) //large (5x7)
+  {
+    _fontWidth = 5;
+    _fontHeight = 7;
+  }
+}
+
+void Graphics::setWordWrap(bool wrap)
+{
+  _wordWrap = wrap;
+}
+
+// Write a character using the Text cursor and stored Font settings.
+void Graphics::writeChar(unsigned char c)
+{
+  if (c == '\n')
+  {
+    _textCursorX = 0;
+    _textCursorY += _fontHeight;
+  }
+  else if (c == '\r')
+  {
+    ; //ignore
+  }
+  else
+  {
+    putChar(_textCursorX, _textCursorY, c, _fontSize, _fontColor);
+
+    _textCursorX += _fontWidth + 1;
+
+    if (_wordWrap && (_textCursorX > (_width - _fontWidth)))
+    {
+      _textCursorX = 0;
+      _textCursorY += _fontHeight + 1;
+    }
+  }
+}
+
+// Put a character on the display using the built-in fonts.
+void Graphics::putChar(int16_t x, int16_t y, unsigned char c, uint8_t size,
+                       Color color)
+{
+  const char text[2] = { (char)c, 0 };
+
+  drawString(x, y, text, Font::builtIn(size), color, _clip);
+}
+
+
+// Draw a string with the given alignment and clip rectangle.
+int16_t Graphics::drawText(int16_t x, int16_t y, const char *text, const Font &font,
+                           Color color, TextAlign align, const Rect *clip)
+{
+  if (align == AlignCenter)
+  {
+    x -= font.measure(text) / 2;
+  }
+  else if (align == AlignRight)
+  {
+    x -= font.measure(text);
+  }
+
+  // Intersect the clip rectangle with the one of the surface.
+  Rect bounds = _clip;
+
+  if (clip)
+  {
+    const int right = std::min<int>(clip->x + clip->w, _clip.x + _clip.w);
+    const int bottom = std::min<int>(clip->y + clip->h, _clip.y + _clip.h);
+
+    bounds.x = std::max<int>(clip->x, _clip.x);
+    bounds.y = std::max<int>(clip->y, _clip.y);
+    bounds.w = std::max<int>(right - bounds.x, 0);
+    bounds.h = std::max<int>(bottom - bounds.y, 0);
+  }
+
+  return drawString(x, y, text, font, color, bounds);
+}
+
+
+// Draw the glyphs of a string pixel by pixel.
+int16_t Graphics::drawString(int16_t x, int16_t y, const char *text,
+                             const Font &font, Color color, const Rect &clip)
+{
+  for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+  {
+    const Font::Glyph *glyph = font.glyph(*c);
+    if (glyph == NULL) continue;
+
+    const int16_t left = x + glyph->xOffset;
+    const int16_t top = y + glyph->yOffset;
+    const uint32_t *rows = font.rows(*glyph);
+
+    for (int j = 0; j < glyph->height; j++)
+    {
+      const int16_t py = top + j;
+      if (py < clip.y || py >= clip.y + clip.h) continue;
+
+      uint32_t line = rows[j];
+
+      for (int i = 0; line != 0; i++, line >>= 1)
+      {
+        const int16_t px = left + i;
+
+        if ((line & 0x1) && px >= clip.x && px < clip.x + clip.w)
+        {
+          drawPixel(px, py, color);
+        }
+      }
+    }
+
+    x += glyph->advance;
+  }
+
+  return x;
+}
+
+
+// Draw one row of a 1-bit bitmap in two colors.
+void Graphics::drawMaskRow(int16_t x, int16_t y, uint32_t mask, uint8_t w,
+                           Color color, Color background)
+{
+  if (y < _clip.y || y >= _clip.y + _clip.h) return;
+
+  for (int i = 0; i < w; i++, mask >>= 1)
+  {
+    if (x + i < _clip.x || x + i >= _clip.x + _clip.w) continue;
+
+    drawPixel(x + i, y, (mask & 0x1) ? color : background);
+  }
+}
+
+
+//Leave output in 24-bit color (#RRGGBB)
+Color Graphics::colorHSV(long hue, uint8_t sat, uint8_t val)
+{
+  return ColorSpace::hsv(hue, sat, val);
+}
@@ -0,0 +1,336 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Base class for anything that can be drawn on: the RGB Matrix itself
+// and offscreen Canvases.
+//
+// All of the shapes and text are built on drawPixel(), which a derived class
+// must implement. Derived classes can override the other virtual methods
+// when they can do the same thing faster than pixel by pixel.
+//
+// Coordinates are signed, so shapes can be partly (or wholly) off the
+// surface. Drawing is limited to a clip rectangle, which is the whole
+// surface unless set otherwise. Lines, spans and filled shapes are clipped
+// before they are rasterized, so the parts outside cost nothing.
+//
+// The ...AA() functions draw anti-aliased lines, circles and arcs: pixels
+// the shape only partly covers are blended with blendPixel().
+
+#ifndef RPI_GRAPHICS_H
+#define RPI_GRAPHICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Font.h"
+
+class Path;
+
+struct Color {
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
+};
+
+
+struct Point {
+  int16_t x;
+  int16_t y;
+};
+
+
+struct Rect {
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+};
+
+
+// x / 255 for x in 0 .. 255 * 255, without a divide. Used to scale by an
+// alpha or a brightness of 0 to 255.
+inline uint8_t div255(uint16_t x)
+{
+  return (x + 1 + (x >> 8)) >> 8;
+}
+
+
+// n / d rounded down (the / operator rounds towards zero).
+inline int32_t floorDiv(int32_t n, int32_t d)
+{
+  int32_t q = n / d;
+
+  if (n % d != 0 && (n < 0) != (d < 0)) q--;
+
+  return q;
+}
+
+
+inline int64_t floorDiv(int64_t n, int64_t d)
+{
+  int64_t q = n / d;
+
+  if (n % d != 0 && (n < 0) != (d < 0)) q--;
+
+  return q;
+}
+
+
+class Graphics
+{
+public:
+
+  // Horizontal alignment of text relative to the x passed to drawText().
+  enum TextAlign { AlignLeft, AlignCenter, AlignRight };
+
+  // Which parts of overlapping outlines are inside a filled shape.
+  //   FillNonZero : inside any outline, except where outlines going the
+  //                 opposite way around cancel out (holes go the other way)
+  //   FillEvenOdd : inside an odd number of outlines
+  enum FillRule { FillNonZero, FillEvenOdd };
+
+
+  Graphics(int16_t width, int16_t height);
+  virtual ~Graphics() {}
+
+  inline int16_t width() const { return _width; }
+  inline int16_t height() const { return _height; }
+
+  // Only draw inside clip (which is limited to the surface).
+  void setClipRect(const Rect &clip);
+
+  // Draw on the whole surface again.
+  void resetClipRect();
+
+  inline const Rect &clipRect() const { return _clip; }
+
+  //Drawing functions
+  // Pixels outside of the clip rectangle are ignored.
+  virtual void drawPixel(int16_t x, int16_t y, Color color) = 0;
+
+  // Draw color over the pixel with coverage alpha (0 - 255). Surfaces that
+  // can't read their pixels back blend over black.
+  virtual void blendPixel(int16_t x, int16_t y, Color color, uint8_t alpha);
+
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, Color color);
+
+  // Anti-aliased line (Wu's algorithm).
+  void drawLineAA(int16_t x0, int16_t y0, int16_t x1, int16_t y1, Color color);
+
+  void drawVLine(int16_t x, int16_t y, int16_t h, Color color);
+
+  // All filled shapes are drawn as horizontal spans with drawHLine().
+  virtual void drawHLine(int16_t x, int16_t y, int16_t w, Color color);
+
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, Color color);
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, Color color);
+
+  void fillScreen(Color color);
+
+  void drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r,
+                     Color color);
+
+  void fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r,
+                     Color color);
+
+  void drawCircle(int16_t x, int16_t y, int16_t r, Color color);
+
+  void drawCircleAA(int16_t x, int16_t y, int16_t r, Color color);
+
+  // Draw one of the four quadrants of a cirle.
+  //   quadrant = 1 : Upper Left
+  //            = 2 : Upper Right
+  //            = 4 : Lower Right
+  //            = 8 : Lower Left
+  void drawCircleQuadrant(int16_t x, int16_t y, int16_t r, uint8_t quadrant,
+                          Color color);
+
+  void fillCircle(int16_t x, int16_t y, int16_t r, Color color);
+
+  // Fill one half of a cirle.
+  //   half = 1 : Left
+  //        = 2 : Right
+  //        = 3 : Both
+  //   stretch = number of pixels to stretch the circle vertically.
+  void fillCircleHalf(int16_t x, int16_t y, int16_t r,
+                      uint8_t half, int16_t stretch,
+                      Color color);
+
+  // Draw an arc.
+  //   x : Segment origin
+  //   y : Segment origin
+  //   r : Segment radius
+  //   startAngle : starting angle in degrees  (East == 0, South == 90)
+  //   endAngle : ending angle in degrees, wrapping around past 360 when it
+  //              is less than startAngle
+  // Each pixel of the arc is drawn once.
+  void drawArc(int16_t x, int16_t y, int16_t r,
+               float startAngle, float endAngle,
+               Color color);
+
+  void drawArcAA(int16_t x, int16_t y, int16_t r,
+                 float startAngle, float endAngle,
+                 Color color);
+
+  // Draw the outline of a wedge.
+  //   x : Segment origin
+  //   y : Segment origin
+  //   r : Segment radius
+  //   startAngle : starting angle in degrees  (East == 0)
+  //   endAngle : ending angle in degrees
+  void drawWedge(int16_t x, int16_t y, int16_t r,
+                 float startAngle, float endAngle,
+                 Color color);
+
+  void drawWedgeAA(int16_t x, int16_t y, int16_t r,
+                   float startAngle, float endAngle,
+                   Color color);
+
+  void fillWedge(int16_t x, int16_t y, int16_t r,
+                 float startAngle, float endAngle,
+                 Color color);
+
+  // Draw the outline of a segment of a ring, between the circles of radius
+  // innerR and outerR. With innerR 0, it is a wedge.
+  void drawRing(int16_t x, int16_t y, int16_t innerR, int16_t outerR,
+                float startAngle, float endAngle,
+                Color color);
+
+  // Fill a segment of a ring (e.g. the bar of a gauge). Each row is filled
+  // as one or two spans, bounded by the circles and the lines at the
+  // angles. The curved edges are the pixels drawArc() draws.
+  void fillRing(int16_t x, int16_t y, int16_t innerR, int16_t outerR,
+                float startAngle, float endAngle,
+                Color color);
+
+  void drawTriangle(int16_t x1, int16_t y1,
+                    int16_t x2, int16_t y2,
+                    int16_t x3, int16_t y3,
+                    Color color);
+
+  void fillTriangle(int16_t x1, int16_t y1,
+                    int16_t x2, int16_t y2,
+                    int16_t x3, int16_t y3,
+                    Color color);
+
+  // Fill a polygon of count points. Pixels whose centers are inside it or
+  // on its edges are filled.
+  void fillPolygon(const Point *points, int count, Color color,
+                   FillRule rule = FillNonZero);
+
+  // Fill all contours of a path together (so one can cut a hole in another).
+  void fillPath(const Path &path, Color color, FillRule rule = FillNonZero);
+
+  // Draw one row of a 1-bit bitmap: bit i of mask is the pixel at (x + i, y).
+  // Set pixels are drawn in color and clear pixels in background.
+  virtual void drawMaskRow(int16_t x, int16_t y, uint32_t mask, uint8_t w,
+                           Color color, Color background);
+
+
+  // Special method to create a color wheel on the display.
+  // Only works on displays where Height == Width.
+  void drawColorWheel();
+
+
+  // When using writeChar(), the cursor is the location where to start.
+  void setTextCursor(int16_t x, int16_t y);
+
+  void setFontColor(Color color);
+
+  // Three sizes are currently available:
+  //   size = 1 : Small  (3x5)
+  //        = 2 : Medium (4x6)
+  //        = 3 : Large  (5x7)
+  void setFontSize(uint8_t size);
+
+  void setWordWrap(bool wrap);
+
+  // Write a character using the text cursor and stored Font settings.
+  void writeChar(unsigned char c);
+
+  // Put a single character on the display.
+  //   x : X for top left origin
+  //   y : Y for top left origin
+  //   c : the character to draw
+  //   size = 1 : Small  (3x5)
+  //        = 2 : Medium (4x6)
+  //        = 2 : Large  (5x7)
+  void putChar(int16_t x, int16_t y, unsigned char c, uint8_t size, Color color);
+
+  // Draw a string.
+  //   x : where the text is aligned to (see align)
+  //   y : top of the line of text
+  //   font : Font::builtIn(size) or a font loaded from a BDF file
+  //   clip : only pixels inside this rectangle are drawn (NULL: the clip
+  //          rectangle)
+  // Returns the x position after the last character.
+  int16_t drawText(int16_t x, int16_t y, const char *text, const Font &font,
+                   Color color, TextAlign align = AlignLeft,
+                   const Rect *clip = NULL);
+
+
+  // Convert an HSV color to an RGB color (see ColorSpace for rows of colors).
+  Color colorHSV(long hue, uint8_t sat, uint8_t val);
+
+
+protected:
+
+  inline bool isClipped(int16_t x, int16_t y) const
+  {
+    return x < _clip.x || y < _clip.y ||
+           x >= _clip.x + _clip.w || y >= _clip.y + _clip.h;
+  }
+
+  // Whether any of the rectangle is inside the clip rectangle.
+  inline bool overlapsClip(int16_t x, int16_t y, int16_t w, int16_t h) const
+  {
+    return x < _clip.x + _clip.w && y < _clip.y + _clip.h &&
+           x + w > _clip.x && y + h > _clip.y;
+  }
+
+  // Clip a horizontal span to the clip rectangle. Returns false if none of
+  // it is inside.
+  inline bool clipSpan(int16_t &x, int16_t y, int16_t &w) const
+  {
+    if (y < _clip.y || y >= _clip.y + _clip.h) return false;
+
+    // The ends in int, as x + w can overflow int16_t.
+    int left = x, right = x + w;
+
+    if (left < _clip.x) left = _clip.x;
+    if (right > _clip.x + _clip.w) right = _clip.x + _clip.w;
+
+    if (left >= right) return false;
+
+    x = left;
+    w = right - left;
+    return true;
+  }
+
+  // Fill r rows above top and below bottom, rounded with radius r, of a
+  // shape whose rows span from left to right.
+  void fillRoundEnds(int16_t left, int16_t right, int16_t top, int16_t bottom,
+                     int16_t r, Color color);
+
+  // Draw the glyphs of a left aligned string, skipping pixels outside of clip
+  // (which is inside the display). Returns the x position after the text.
+  virtual int16_t drawString(int16_t x, int16_t y, const char *text,
+                             const Font &font, Color color, const Rect &clip);
+
+  const int16_t _width;
+  const int16_t _height;
+
+  Rect _clip;
+
+  // Members for writing text
+  int16_t _textCursorX, _textCursorY;
+  Color _fontColor;
+  uint8_t _fontSize;
+  uint8_t _fontWidth;
+  uint8_t _fontHeight;
+  bool _wordWrap;
+};
+
+#endif
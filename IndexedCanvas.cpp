@@ -0,0 +1,55 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// An offscreen image of 8 bit palette indexes.
+
+#include "IndexedCanvas.h"
+
+#include <string.h>
+
+
+IndexedCanvas::IndexedCanvas(int16_t width, int16_t height)
+  : Graphics(width, height)
+{
+  _pixels = new uint8_t[width * height];
+  clear();
+}
+
+
+IndexedCanvas::~IndexedCanvas()
+{
+  delete [] _pixels;
+}
+
+
+void IndexedCanvas::drawPixel(int16_t x, int16_t y, Color color)
+{
+  if (isClipped(x, y)) return;
+
+  _pixels[y * _width + x] = color.red;
+}
+
+
+void IndexedCanvas::blendPixel(int16_t x, int16_t y, Color color,
+                               uint8_t alpha)
+{
+  if (alpha >= 128) drawPixel(x, y, color);
+}
+
+
+void IndexedCanvas::clear(uint8_t i)
+{
+  memset(_pixels, i, _width * _height);
+}
+
+
+void IndexedCanvas::toCanvas(const Palette &palette, Canvas *canvas) const
+{
+  for (int y = 0; y < _height && y < canvas->height(); y++)
+  {
+    const int w = (_width < canvas->width()) ? _width : canvas->width();
+
+    palette.map(row(y), canvas->row(y), w);
+  }
+}
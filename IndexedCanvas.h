@@ -0,0 +1,77 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// An offscreen image of 8 bit palette indexes instead of colors.
+//
+// Draw the content once, then animate it by changing the palette only:
+// RgbMatrix::drawIndexed() and convertFrame() expand the palette into bit
+// planes once and convert the whole image with it, so color cycling costs a
+// palette update and one conversion instead of redrawing every shape. The
+// image also takes a third of the memory of a Canvas.
+//
+// All of the Graphics drawing functions work, with index(i) as the color.
+
+#ifndef RPI_INDEXEDCANVAS_H
+#define RPI_INDEXEDCANVAS_H
+
+#include "Canvas.h"
+#include "Graphics.h"
+#include "Palette.h"
+
+#include <stdint.h>
+
+
+class IndexedCanvas : public Graphics
+{
+public:
+
+  // All pixels start out as index 0.
+  IndexedCanvas(int16_t width, int16_t height);
+  ~IndexedCanvas();
+
+  // The color to draw palette index i with. Only its red channel is used.
+  static inline Color index(uint8_t i)
+  {
+    Color c;
+    c.red = i;
+    c.green = c.blue = 0;
+    return c;
+  }
+
+  void drawPixel(int16_t x, int16_t y, Color color);
+
+  // Indexes can't be blended: pixels at least half covered get the index.
+  void blendPixel(int16_t x, int16_t y, Color color, uint8_t alpha);
+
+  // Set all pixels to index i.
+  void clear(uint8_t i = 0);
+
+  inline uint8_t getPixel(int16_t x, int16_t y) const
+  {
+    return _pixels[y * _width + x];
+  }
+
+  inline void setPixel(int16_t x, int16_t y, uint8_t i)
+  {
+    _pixels[y * _width + x] = i;
+  }
+
+  // The indexes of row y, left to right.
+  inline uint8_t *row(int16_t y) { return &_pixels[y * _width]; }
+  inline const uint8_t *row(int16_t y) const { return &_pixels[y * _width]; }
+
+  // Look up every pixel in palette, onto a canvas of the same size.
+  void toCanvas(const Palette &palette, Canvas *canvas) const;
+
+
+private:
+
+  // Not copyable.
+  IndexedCanvas(const IndexedCanvas &);
+  IndexedCanvas &operator=(const IndexedCanvas &);
+
+  uint8_t *_pixels;
+};
+
+#endif
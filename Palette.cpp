@@ -0,0 +1,82 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A table of 256 colors picked by an 8 bit index.
+
+#include "Palette.h"
+#include "ColorSpace.h"
+
+#include <string.h>
+
+
+Palette::Palette()
+{
+  memset(_colors, 0, sizeof(_colors));
+}
+
+
+void Palette::setGradient(const Color *colors, int count, bool wrap)
+{
+  if (count < 2) return;
+
+  // Blends between the colors, spread over the whole palette. Without wrap,
+  // the last entry is exactly the last color.
+  const int blends = wrap ? count : count - 1;
+  const int span = wrap ? Size : Size - 1;
+
+  for (int i = 0; i < Size; i++)
+  {
+    // Position in 1/256ths of a blend: blend k, fraction t.
+    const int step = i * blends * 256 / span;
+    const int k = step >> 8;
+    const int t = step & 255;
+
+    const Color &a = colors[k % count];
+    const Color &b = colors[(k + 1) % count];
+
+    _colors[i].red   = a.red   + ((b.red   - a.red)   * t) / 256;
+    _colors[i].green = a.green + ((b.green - a.green) * t) / 256;
+    _colors[i].blue  = a.blue  + ((b.blue  - a.blue)  * t) / 256;
+  }
+}
+
+
+void Palette::setRainbow(uint8_t sat, uint8_t val)
+{
+  for (int i = 0; i < Size; i++)
+  {
+    _colors[i] = ColorSpace::hsv(i * ColorSpace::HueSteps / Size, sat, val);
+  }
+}
+
+
+void Palette::rotate(int steps, uint8_t first, uint8_t last)
+{
+  if (last <= first) return;
+
+  const int count = last - first + 1;
+
+  steps %= count;
+  if (steps < 0) steps += count;
+  if (steps == 0) return;
+
+  Color rotated[Size];
+
+  for (int i = 0; i < count; i++)
+  {
+    rotated[(i + steps) % count] = _colors[first + i];
+  }
+
+  memcpy(&_colors[first], rotated, count * sizeof(Color));
+}
+
+
+void Palette::map(const uint8_t *indexes, Color *out, int count,
+                  uint8_t offset) const
+{
+  for (int i = 0; i < count; i++)
+  {
+    out[i] = _colors[(uint8_t)(indexes[i] + offset)];
+  }
+}
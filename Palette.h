@@ -0,0 +1,53 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A table of 256 colors picked by an 8 bit index.
+//
+// Effects like plasma compute an index for each pixel instead of a color,
+// and look the colors up a row at a time. Cycling the colors is only a
+// different offset added to the indexes.
+
+#ifndef RPI_PALETTE_H
+#define RPI_PALETTE_H
+
+#include "Graphics.h"
+
+#include <stdint.h>
+
+
+class Palette
+{
+public:
+
+  static const int Size = 256;
+
+  // All colors start out black.
+  Palette();
+
+  // Blend evenly from each of count colors (at least 2) to the next. With
+  // wrap, the last color blends back into the first, so cycling the palette
+  // has no seam.
+  void setGradient(const Color *colors, int count, bool wrap = false);
+
+  // Hues once around the color wheel.
+  void setRainbow(uint8_t sat = 255, uint8_t val = 255);
+
+  inline void setColor(uint8_t i, Color color) { _colors[i] = color; }
+  inline Color color(uint8_t i) const { return _colors[i]; }
+
+  // Cycle the colors of entries first to last (inclusive) by steps: each
+  // entry gets the color of the entry steps before it, wrapping around.
+  void rotate(int steps, uint8_t first = 0, uint8_t last = Size - 1);
+
+  // Look up count indexes, each plus offset (wrapping around).
+  void map(const uint8_t *indexes, Color *out, int count,
+           uint8_t offset = 0) const;
+
+
+private:
+
+  Color _colors[Size];
+};
+
+#endif
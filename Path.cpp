@@ -0,0 +1,80 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A shape made of closed outlines of straight edges.
+
+#include "Path.h"
+
+#include <math.h>
+
+
+// Points further out than this are clamped, so edges fit in 32 bit math.
+static const float Limit = 32767;
+
+
+Path::Path()
+{
+}
+
+
+void Path::clear()
+{
+  _vertices.clear();
+  _starts.clear();
+}
+
+
+void Path::moveTo(float x, float y)
+{
+  _starts.push_back(_vertices.size());
+  addVertex(x, y);
+}
+
+
+void Path::lineTo(float x, float y)
+{
+  if (_starts.empty()) moveTo(0, 0);
+
+  addVertex(x, y);
+}
+
+
+void Path::addPolygon(const Point *points, int count)
+{
+  if (count < 1) return;
+
+  _starts.push_back(_vertices.size());
+
+  for (int i = 0; i < count; i++)
+  {
+    Vertex v;
+    v.x = points[i].x * SubPixels;
+    v.y = points[i].y * SubPixels;
+    _vertices.push_back(v);
+  }
+}
+
+
+const Path::Vertex *Path::contour(int i, int *count) const
+{
+  const int end = (i + 1 < contourCount()) ? _starts[i + 1] : vertexCount();
+
+  *count = end - _starts[i];
+
+  return &_vertices[_starts[i]];
+}
+
+
+void Path::addVertex(float x, float y)
+{
+  if (x < -Limit) x = -Limit;
+  if (x > Limit) x = Limit;
+  if (y < -Limit) y = -Limit;
+  if (y > Limit) y = Limit;
+
+  Vertex v;
+  v.x = lroundf(x * SubPixels);
+  v.y = lroundf(y * SubPixels);
+  _vertices.push_back(v);
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A shape made of closed outlines (contours) of straight edges, for
+// Graphics::fillPath(). Contours can overlap or have holes, e.g. an icon
+// and its cut outs; the fill rule decides what is inside.
+//
+// Points are in pixels, with whole numbers at pixel centers (as for the
+// other drawing functions), and are kept in 1/16ths of a pixel so shapes
+// scaled from vector artwork keep their proportions.
+
+#ifndef RPI_PATH_H
+#define RPI_PATH_H
+
+#include "Graphics.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+
+class Path
+{
+public:
+
+  // Fraction of a pixel points are kept in.
+  static const int SubPixels = 16;
+
+  struct Vertex {
+    int32_t x;  // In 1/SubPixels of a pixel
+    int32_t y;
+  };
+
+
+  Path();
+
+  // Remove all contours.
+  void clear();
+
+  // Start a new contour at (x, y).
+  void moveTo(float x, float y);
+
+  // Add an edge from the last point to (x, y). Each contour is closed by an
+  // edge back to its first point.
+  void lineTo(float x, float y);
+
+  // Add a polygon as a contour of its own.
+  void addPolygon(const Point *points, int count);
+
+  inline int contourCount() const { return _starts.size(); }
+
+  // The vertices of contour i. Sets count to how many there are.
+  const Vertex *contour(int i, int *count) const;
+
+  inline int vertexCount() const { return _vertices.size(); }
+
+
+private:
+
+  void addVertex(float x, float y);
+
+  std::vector<Vertex> _vertices;
+  std::vector<int> _starts;  // Index of the first vertex of each contour
+};
+
+#endif
@@ -0,0 +1,234 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Scale images of any size onto a Canvas.
+
+#include "Resampler.h"
+
+#include <math.h>
+
+
+Resampler::Resampler(Filter filter) : _filter(filter)
+{
+}
+
+
+void Resampler::setFilter(Filter filter)
+{
+  _filter = filter;
+}
+
+
+void Resampler::resample(const Canvas &src, Canvas *dst)
+{
+  const Rect srcRect = { 0, 0, src.width(), src.height() };
+  const Rect dstRect = { 0, 0, dst->width(), dst->height() };
+
+  resample(src, srcRect, dst, dstRect);
+}
+
+
+void Resampler::resample(const Canvas &src, const Rect &srcRect,
+                         Canvas *dst, const Rect &dstRect)
+{
+  if (srcRect.w <= 0 || srcRect.h <= 0 || dstRect.w <= 0 || dstRect.h <= 0)
+    return;
+
+  prepare(_x, srcRect.w, dstRect.w);
+  prepare(_y, srcRect.h, dstRect.h);
+
+  // Only the source rows some destination row uses are scaled horizontally.
+  const int firstRow = _y.first[0];
+  const int lastRow = _y.first[dstRect.h - 1] + _y.count[dstRect.h - 1];
+  const int stride = dstRect.w * 3;
+
+  _rows.resize((lastRow - firstRow) * stride);
+
+  // Horizontal pass: 8 bit channels times weights fit in 20 bits.
+  for (int j = firstRow; j < lastRow; j++)
+  {
+    const uint8_t *in = (const uint8_t *)(src.row(srcRect.y + j) + srcRect.x);
+    uint32_t *out = &_rows[(j - firstRow) * stride];
+
+    for (int i = 0; i < dstRect.w; i++)
+    {
+      const uint8_t *p = in + _x.first[i] * 3;
+      const uint16_t *w = &_x.weight[_x.offset[i]];
+      const int count = _x.count[i];
+
+      uint32_t r = 0, g = 0, b = 0;
+
+      for (int k = 0; k < count; k++)
+      {
+        r += p[0] * w[k];
+        g += p[1] * w[k];
+        b += p[2] * w[k];
+        p += 3;
+      }
+
+      out[0] = r;
+      out[1] = g;
+      out[2] = b;
+      out += 3;
+    }
+  }
+
+  // Vertical pass: the sums fit in 32 bits, and are rounded back to 8 bits.
+  // Whole rows are summed at a time, so the inner loops run straight along
+  // memory and the compiler can vectorize them.
+  const uint32_t round = 1u << (2 * WeightBits - 1);
+
+  _sums.resize(stride);
+
+  for (int j = 0; j < dstRect.h; j++)
+  {
+    const uint16_t *w = &_y.weight[_y.offset[j]];
+    const int count = _y.count[j];
+    const uint32_t *in = &_rows[(_y.first[j] - firstRow) * stride];
+    uint32_t *sums = &_sums[0];
+
+    for (int i = 0; i < stride; i++)
+    {
+      sums[i] = round;
+    }
+
+    for (int k = 0; k < count; k++)
+    {
+      const uint32_t weight = w[k];
+      const uint32_t *row = in + k * stride;
+
+      for (int i = 0; i < stride; i++)
+      {
+        sums[i] += row[i] * weight;
+      }
+    }
+
+    uint8_t *out = (uint8_t *)(dst->row(dstRect.y + j) + dstRect.x);
+
+    for (int i = 0; i < stride; i++)
+    {
+      out[i] = sums[i] >> (2 * WeightBits);
+    }
+  }
+}
+
+
+Rect Resampler::fitRect(int16_t srcW, int16_t srcH, int16_t dstW, int16_t dstH)
+{
+  Rect rect = { 0, 0, dstW, dstH };
+
+  if (srcW <= 0 || srcH <= 0) return rect;
+
+  // Compare srcW / srcH with dstW / dstH without dividing.
+  if ((int32_t)srcW * dstH > (int32_t)srcH * dstW)
+  {
+    rect.h = ((int32_t)dstW * srcH + srcW / 2) / srcW;
+    if (rect.h < 1) rect.h = 1;
+  }
+  else
+  {
+    rect.w = ((int32_t)dstH * srcW + srcH / 2) / srcH;
+    if (rect.w < 1) rect.w = 1;
+  }
+
+  rect.x = (dstW - rect.w) / 2;
+  rect.y = (dstH - rect.h) / 2;
+
+  return rect;
+}
+
+
+void Resampler::prepare(Axis &axis, int srcLength, int dstLength)
+{
+  if (axis.srcLength == srcLength && axis.dstLength == dstLength &&
+      axis.filter == _filter)
+    return;
+
+  axis.srcLength = srcLength;
+  axis.dstLength = dstLength;
+  axis.filter = _filter;
+
+  axis.first.resize(dstLength);
+  axis.count.resize(dstLength);
+  axis.offset.resize(dstLength);
+  axis.weight.clear();
+
+  const double scale = (double)srcLength / dstLength;
+  const int one = 1 << WeightBits;
+
+  std::vector<double> weights;
+
+  for (int i = 0; i < dstLength; i++)
+  {
+    int first;
+    weights.clear();
+
+    if (_filter == FilterNearest)
+    {
+      first = (int)((i + 0.5) * scale);
+      weights.push_back(1.0);
+    }
+    else if (_filter == FilterBilinear)
+    {
+      // Source position of the middle of the pixel, between two pixels.
+      double center = (i + 0.5) * scale - 0.5;
+
+      if (center < 0) center = 0;
+      if (center > srcLength - 1) center = srcLength - 1;
+
+      first = (int)center;
+      const double fraction = center - first;
+
+      weights.push_back(1.0 - fraction);
+
+      if (first + 1 < srcLength && fraction > 0)
+      {
+        weights.push_back(fraction);
+      }
+    }
+    else  // FilterArea
+    {
+      // The source span [start, end) this pixel covers. When scaling up it
+      // is less than a pixel wide, so it mostly falls in one source pixel.
+      const double start = i * scale;
+      const double end = (i + 1) * scale;
+
+      first = (int)start;
+      const int last = (int)ceil(end) - 1;
+
+      for (int k = first; k <= last && k < srcLength; k++)
+      {
+        const double left = (k > start) ? k : start;
+        const double right = (k + 1 < end) ? k + 1 : end;
+
+        weights.push_back(right - left);
+      }
+    }
+
+    if (first >= srcLength) first = srcLength - 1;
+
+    // Fixed point weights that add up to exactly one.
+    double total = 0;
+    for (size_t k = 0; k < weights.size(); k++) total += weights[k];
+
+    axis.first[i] = first;
+    axis.count[i] = weights.size();
+    axis.offset[i] = axis.weight.size();
+
+    int sum = 0;
+    size_t largest = 0;
+
+    for (size_t k = 0; k < weights.size(); k++)
+    {
+      const int w = (int)(weights[k] / total * one + 0.5);
+
+      axis.weight.push_back(w);
+      sum += w;
+
+      if (weights[k] > weights[largest]) largest = k;
+    }
+
+    axis.weight[axis.offset[i] + largest] += one - sum;
+  }
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Scale images of any size onto a Canvas, e.g. video frames or animations
+// onto the matrix.
+//
+// Scaling is separable: each destination pixel is a weighted sum of a run of
+// source pixels, first along rows, then along columns. The runs and weights
+// of both axes are computed once per source and destination size, so scaling
+// a stream of same sized frames is only the two passes of integer sums.
+//
+// Filters:
+//   FilterNearest  : the source pixel nearest to the middle of each pixel
+//   FilterBilinear : interpolated from the two nearest source pixels
+//   FilterArea     : the average of the source area each pixel covers, the
+//                    best choice for scaling down (e.g. video to 32x32)
+
+#ifndef RPI_RESAMPLER_H
+#define RPI_RESAMPLER_H
+
+#include "Canvas.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+
+class Resampler
+{
+public:
+
+  enum Filter { FilterNearest, FilterBilinear, FilterArea };
+
+  Resampler(Filter filter = FilterArea);
+
+  void setFilter(Filter filter);
+  inline Filter filter() const { return _filter; }
+
+  // Scale all of src onto all of dst.
+  void resample(const Canvas &src, Canvas *dst);
+
+  // Scale the srcRect part of src onto the dstRect part of dst. Both
+  // rectangles must be inside their canvas.
+  void resample(const Canvas &src, const Rect &srcRect,
+                Canvas *dst, const Rect &dstRect);
+
+  // The largest rectangle with the aspect ratio of a srcW x srcH image that
+  // fits in dstW x dstH, centered.
+  static Rect fitRect(int16_t srcW, int16_t srcH, int16_t dstW, int16_t dstH);
+
+
+private:
+
+  // Weights of the taps of a destination pixel add up to this.
+  static const int WeightBits = 12;
+
+  // The taps of every destination pixel along one axis: count[i] source
+  // pixels starting at first[i], with weights from weight[offset[i]].
+  struct Axis {
+    int srcLength;
+    int dstLength;
+    Filter filter;
+    std::vector<int> first;
+    std::vector<int> count;
+    std::vector<int> offset;
+    std::vector<uint16_t> weight;
+
+    Axis() : srcLength(0), dstLength(0), filter(FilterNearest) {}
+  };
+
+  // Compute the taps unless the axis already has them for these lengths.
+  void prepare(Axis &axis, int srcLength, int dstLength);
+
+  Filter _filter;
+  Axis _x;
+  Axis _y;
+
+  // Rows scaled horizontally, before the vertical pass (3 channels each).
+  std::vector<uint32_t> _rows;
+  std::vector<uint32_t> _sums;  // One row of the vertical pass
+};
+
+#endif
@@ -9,15 +9,11 @@
 //   https://github.com/hzeller/rpi-rgb-led-matrix
 
 #include "RgbMatrix.h"
-
-#include "Font3x5.h"
-#include "Font4x6.h"
-#include "Font5x7.h"
+#include "Sprite.h"
 
 //#include "Gamma.h"
 
 #include <assert.h>
-#include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -25,10 +21,6 @@
 #include <time.h>
 #include <unistd.h>
 
-#include <algorithm>
-
-#define _USE_MATH_DEFINES
-
 #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
 
 
@@ -51,6 +43,15 @@ const long RowSleepNanos[8] = {   // Only using the first PwmBits elements.
   (128 * RowClockTime) - RowClockTime, // too much flicker.
 };
 
+// 4x4 Bayer matrix: thresholds for ordered dithering, spread out so that any
+// level lights an even pattern of pixels.
+static const uint8_t Bayer[4][4] = {
+  {  0,  8,  2, 10 },
+  { 12,  4, 14,  6 },
+  {  3, 11,  1,  9 },
+  { 15,  7, 13,  5 }
+};
+
 static void sleepNanos(long nanos)
 {
   // For sleep times above 20usec, nanosleep seems to be fine, but it has
@@ -77,7 +78,10 @@ static void sleepNanos(long nanos)
 
 
 
-RgbMatrix::RgbMatrix(GpioProxy *io) : _gpio(io)
+RgbMatrix::RgbMatrix(GpioProxy *io)
+  : Graphics(Width, Height), _gpio(io), _shownFrame(NULL), _refreshes(0),
+    _refreshesAtShow(0),
+    _dither(DitherNone), _ditherPhase(0), _corrected(false)
 {
   // Tell GPIO about the pins we will use.
   GpioPins b;
@@ -90,23 +94,35 @@ RgbMatrix::RgbMatrix(GpioProxy *io) : _gpio(io)
   b.bits.rowAddress = 0xf; //binary: 1111
 
   // Initialize outputs, make sure that all of these are supported bits.
-  const uint32_t result = _gpio->setupOutputBits(b.raw);
+  // Without GPIO the matrix is only used to convert images (e.g. by tools
+  // that prepare animations offline).
+  if (_gpio)
+  {
+    const uint32_t result = _gpio->setupOutputBits(b.raw);
 
-  assert(result == b.raw);
+    assert(result == b.raw);
+  }
   assert(PwmBits < 8);  // only up to 7 makes sense.
 
-  //Initialize text members
-  _textCursorX = 0;
-  _textCursorY = 0;
-  Color white;
-  white.red = 255;
-  white.green = 255;
-  white.blue = 255;
-  _fontColor = white;
-  _fontSize = 1;
-  _fontWidth = 3;
-  _fontHeight = 5;
-  _wordWrap = true;
+  GpioPins upper, lower;
+  upper.bits.r1 = upper.bits.g1 = upper.bits.b1 = 1;
+  lower.bits.r2 = lower.bits.g2 = lower.bits.b2 = 1;
+  _upperBits = upper.raw;
+  _lowerBits = lower.raw;
+  _colorBits = _upperBits | _lowerBits;
+
+  // Bits for every combination of one R, G and B bit (see writeRow()).
+  for (int code = 0; code < 8; code++)
+  {
+    GpioPins upperPins, lowerPins;
+
+    upperPins.bits.r1 = lowerPins.bits.r2 = (code & 0x1) != 0;
+    upperPins.bits.g1 = lowerPins.bits.g2 = (code & 0x2) != 0;
+    upperPins.bits.b1 = lowerPins.bits.b2 = (code & 0x4) != 0;
+
+    _rgbBits[0][code] = upperPins.raw;
+    _rgbBits[1][code] = lowerPins.raw;
+  }
 
   clearDisplay();
 }
@@ -115,50 +131,62 @@ RgbMatrix::RgbMatrix(GpioProxy *io) : _gpio(io)
 // Write pixels to the LED panel.
 void RgbMatrix::updateDisplay()
 {
-  GpioPins serialMask;   // Mask of bits we need to set while clocking in.
-  serialMask.bits.r1 = serialMask.bits.g1 = serialMask.bits.b1 = 1;
-  serialMask.bits.r2 = serialMask.bits.g2 = serialMask.bits.b2 = 1;
-  serialMask.bits.clock = 1;
+  if (_gpio == NULL) return;
 
   GpioPins rowMask;
   rowMask.bits.rowAddress = 0xf;
 
-  GpioPins clock, outputEnable, latch;
+  GpioPins outputEnable, latch;
 
-  clock.bits.clock = 1;
   outputEnable.bits.outputEnabled = 1;
   latch.bits.latch = 1;
 
   GpioPins rowBits;
 
+  // Show the same frame for the whole refresh, even if it is swapped. The
+  // count tells waitForRefresh() a refresh started before the frame is read.
+  _refreshes++;
+  __sync_synchronize();
+  const Frame *frame = _shownFrame ? _shownFrame : &_frame;
+
+  // Copy of the data last clocked into the shift registers of the panel.
+  TwoRows clocked;
+  bool clockedValid = false;
+
   for (uint8_t row = 0; row < RowsPerSubPanel; ++row)
   {
     // Rows can't be switched very quickly without ghosting, so we do the
     // full PWM of one row before switching rows.
     for (int b = 0; b < PwmBits; b++)
     {
-      const TwoRows &rowData = _plane[b].row[row];
-
-      // Clock in the row. The time this takes is the smallest time we can
-      // leave the LEDs on, thus the smallest time-constant we can use for
-      // PWM (doubling the sleep time with each bit).
-      // So this is the critical path; I'd love to know if we can employ some
-      // DMA techniques to speed this up.
-      // (With this code, one row roughly takes 3.0 - 3.4usec to clock in).
-      //
-      // However, in particular for longer chaining, it seems we need some more
-      // wait time to settle.
-      const long StabilizeWaitNanos = 256; //TODO: mateo was 256
-
-      for (uint8_t col = 0; col < ColumnCnt; ++col)
+      const TwoRows &rowData = frame->plane[b].row[row];
+
+      // If we use less bits, then use the upper areas which leaves us more
+      // CPU time to do other stuff.
+      const long onTime = RowSleepNanos[b + (7 - PwmBits)];
+
+      if (frame->litColumns[b][row] == 0)
       {
-        const GpioPins &out = rowData.column[col];
-        _gpio->clearBits(~out.raw & serialMask.raw);  // also: resets clock.
-        sleepNanos(StabilizeWaitNanos);
-        _gpio->setBits(out.raw & serialMask.raw);
-        sleepNanos(StabilizeWaitNanos);
-        _gpio->setBits(clock.raw);
-        sleepNanos(StabilizeWaitNanos);
+        // Nothing is lit in this plane, so don't clock in a row of zeros.
+        // Keep the previous plane on for the time clocking in would have
+        // taken, then switch off for the time this plane would be shown.
+        sleepNanos(RowClockTime);
+        _gpio->setBits(outputEnable.raw);
+        sleepNanos(onTime);
+        continue;
+      }
+
+      if (clockedValid && memcmp(&clocked, &rowData, sizeof(TwoRows)) == 0)
+      {
+        // The shift registers already hold this data (e.g. two identical
+        // planes in a row), so latching it again is enough.
+        sleepNanos(RowClockTime);
+      }
+      else
+      {
+        clockIn(rowData);
+        memcpy(&clocked, &rowData, sizeof(TwoRows));
+        clockedValid = true;
       }
 
       _gpio->setBits(outputEnable.raw);  // switch off while strobe (latch).
@@ -173,18 +201,82 @@ void RgbMatrix::updateDisplay()
       // Now switch on for the given sleep time.
       _gpio->clearBits(outputEnable.raw);
 
-      // If we use less bits, then use the upper areas which leaves us more
-      // CPU time to do other stuff.
-      sleepNanos(RowSleepNanos[b + (7 - PwmBits)]);
+      sleepNanos(onTime);
     }
   }
+
+  __sync_synchronize();
+  _refreshes++;
+}
+
+
+void RgbMatrix::setDither(Dither dither)
+{
+  _dither = dither;
+}
+
+
+void RgbMatrix::setColorCorrection(int board, const ColorCorrection &correction)
+{
+  if (board < 0 || board >= ChainedBoardsCnt) return;
+
+  _corrections[board] = correction;
+
+  _corrected = false;
+
+  for (int i = 0; i < ChainedBoardsCnt; i++)
+  {
+    if (!_corrections[i].isIdentity()) _corrected = true;
+  }
+
+  for (int y = 0; y < Height; y++)
+  {
+    updatePlanes(0, y, Width);
+  }
+}
+
+
+// Clock one row of data into the shift registers of the panel.
+void RgbMatrix::clockIn(const TwoRows &rowData)
+{
+  GpioPins serialMask;   // Mask of bits we need to set while clocking in.
+  serialMask.bits.r1 = serialMask.bits.g1 = serialMask.bits.b1 = 1;
+  serialMask.bits.r2 = serialMask.bits.g2 = serialMask.bits.b2 = 1;
+  serialMask.bits.clock = 1;
+
+  GpioPins clock;
+  clock.bits.clock = 1;
+
+  // Clock in the row. The time this takes is the smallest time we can
+  // leave the LEDs on, thus the smallest time-constant we can use for
+  // PWM (doubling the sleep time with each bit).
+  // So this is the critical path; I'd love to know if we can employ some
+  // DMA techniques to speed this up.
+  // (With this code, one row roughly takes 3.0 - 3.4usec to clock in).
+  //
+  // However, in particular for longer chaining, it seems we need some more
+  // wait time to settle.
+  const long StabilizeWaitNanos = 256; //TODO: mateo was 256
+
+  for (uint8_t col = 0; col < ColumnCnt; ++col)
+  {
+    const GpioPins &out = rowData.column[col];
+    _gpio->clearBits(~out.raw & serialMask.raw);  // also: resets clock.
+    sleepNanos(StabilizeWaitNanos);
+    _gpio->setBits(out.raw & serialMask.raw);
+    sleepNanos(StabilizeWaitNanos);
+    _gpio->setBits(clock.raw);
+    sleepNanos(StabilizeWaitNanos);
+  }
 }
 
 
 // Clear the entire display
 void RgbMatrix::clearDisplay()
 {
-  memset(&_plane, 0, sizeof(_plane));
+  memset(&_frame.plane, 0, sizeof(_frame.plane));
+  memset(&_frame.litColumns, 0, sizeof(_frame.litColumns));
+  memset(_pixels, 0, sizeof(_pixels));
 }
 
 
@@ -195,13 +287,21 @@ void RgbMatrix::clearRect(uint8_t fx, uint8_t fy, uint8_t fw, uint8_t fh)
   maxX = (fx + fw) > Width ? Width : (fx + fw);
   maxY = (fy + fh) > Height ? Height : (fy + fh);
 
+  for (int y = fy; y < maxY; y++)
+  {
+    for (int x = fx; x < maxX; x++)
+    {
+      _pixels[y][x].red = _pixels[y][x].green = _pixels[y][x].blue = 0;
+    }
+  }
+
   for (int b = PwmBits - 1; b >= 0; b--)
   {
     for (int x = fx; x < maxX; x++)
     {
       for (int y = fy; y < maxY; y++)
       {
-        GpioPins *bits = &_plane[b].row[y & 0xf].column[x];
+        GpioPins *bits = &_frame.plane[b].row[y & 0xf].column[x];
 
         if (y < 16)
         {
@@ -220,75 +320,98 @@ void RgbMatrix::clearRect(uint8_t fx, uint8_t fy, uint8_t fw, uint8_t fh)
       }
     }
   }
+
+  countLitColumns();
 }
 
 
 // Fade whatever is on the display to black.
 void RgbMatrix::fadeDisplay()
 {
-  for (int b = PwmBits - 1; b >= 0; b--)
+  fadeRect(0, 0, Width, Height);
+}
+
+ 
+// Fade whatever is shown inside the given Rectangle. 
+void RgbMatrix::fadeRect(uint8_t fx, uint8_t fy, uint8_t fw, uint8_t fh)
+{
+  // Halving the levels PwmBits times takes the brightest pixels to black.
+  for (int b = 0; b < PwmBits; b++)
   {
-    for (int x = 0; x < Width; x++)
-    {
-      for (int y = 0; y < Height; y++)
-      {
-        GpioPins *bits = &_plane[b].row[y & 0xf].column[x];
+    decayRect(fx, fy, fw, fh, 128);
 
-        if (y < 16)
-        {
-          // Upper sub-panel
-	  bits->bits.r1 >>= 1;
-          bits->bits.g1 >>= 1;
-          bits->bits.b1 >>= 1;
-        }
-        else
-        {
-          // Lower sub-panel
-          bits->bits.r2 >>= 1;
-          bits->bits.g2 >>= 1;
-          bits->bits.b2 >>= 1;
-        }
-      }
-    }
-    //TODO: make this dependent on PwmBits (longer sleep for fewer PwmBits).
+    //TODO: make this param and/or dependent on PwmBits (longer sleep for fewer PwmBits).
     usleep(100000); // 1/10 second
   }
 }
 
- 
-// Fade whatever is shown inside the given Rectangle. 
-void RgbMatrix::fadeRect(uint8_t fx, uint8_t fy, uint8_t fw, uint8_t fh)
+
+// Multiply count bytes by factor / 256 (up to 256). The bytes are taken
+// four at a time as a word: the even and the odd bytes are each scaled by
+// one multiply, every product in its own 16 bits, so it takes a few
+// instructions for four channels (the Raspberry Pi's ARMv6 has no vector
+// unit to do more at once).
+static void scaleBytes(uint8_t *bytes, int count, uint32_t factor)
 {
-  uint8_t maxX, maxY;
-  maxX = (fx + fw) > Width ? Width : (fx + fw);
-  maxY = (fy + fh) > Height ? Height : (fy + fh);
+  int i = 0;
 
-  for (int b = PwmBits - 1; b >= 0; b--)
+  for (; i + 4 <= count; i += 4)
   {
-    for (int x = fx; x < maxX; x++)
-    {
-      for (int y = fy; y < maxY; y++)
-      {
-        GpioPins *bits = &_plane[b].row[y & 0xf].column[x];
+    uint32_t word;
+    memcpy(&word, bytes + i, 4);
 
-        if (y < 16)
-        {
-          // Upper sub-panel
-	  bits->bits.r1 >>= 1;
-          bits->bits.g1 >>= 1;
-          bits->bits.b1 >>= 1;
-        }
-        else
-        {
-          // Lower sub-panel
-          bits->bits.r2 >>= 1;
-          bits->bits.g2 >>= 1;
-          bits->bits.b2 >>= 1;
-        }
-      }
+    const uint32_t even = ((word & 0x00ff00ff) * factor >> 8) & 0x00ff00ff;
+    const uint32_t odd = (((word >> 8) & 0x00ff00ff) * factor) & 0xff00ff00;
+
+    word = even | odd;
+    memcpy(bytes + i, &word, 4);
+  }
+
+  for (; i < count; i++)
+  {
+    bytes[i] = (bytes[i] * factor) >> 8;
+  }
+}
+
+
+void RgbMatrix::decay(uint8_t factor)
+{
+  decayRect(0, 0, Width, Height, factor);
+}
+
+
+void RgbMatrix::decayRect(int16_t x, int16_t y, int16_t w, int16_t h,
+                          uint8_t factor)
+{
+  // Only the part on the display, in int as the sums can overflow int16_t.
+  const int right = std::min<int>(x + w, (int)Width);
+  const int bottom = std::min<int>(y + h, (int)Height);
+
+  x = std::max<int16_t>(x, 0);
+  y = std::max<int16_t>(y, 0);
+
+  if (right <= x || bottom <= y) return;
+
+  w = right - x;
+  h = bottom - y;
+
+  // Scale the colors, all at once if the rows are whole, and convert them
+  // into the bit planes again.
+  if (w == Width)
+  {
+    scaleBytes(&_pixels[y][0].red, h * Width * sizeof(Color), factor);
+  }
+  else
+  {
+    for (int16_t j = y; j < bottom; j++)
+    {
+      scaleBytes(&_pixels[j][x].red, w * sizeof(Color), factor);
     }
-    //TODO: make this param and/or dependent on PwmBits (longer sleep for fewer PwmBits).
-    usleep(100000); // 1/10 second
+  }
+
+  for (int16_t j = y; j < bottom; j++)
+  {
+    updatePlanes(x, j, w);
   }
 }
 
@@ -296,41 +419,25 @@ void RgbMatrix::fadeRect(uint8_t fx, uint8_t fy, uint8_t fw, uint8_t fh)
 // Call this after drawing on the display and before calling fadeIn().
 void RgbMatrix::setupFadeIn()
 {
-  // Copy the _plane and then set all bits to 0.
-  memcpy(&_fadeInPlane, &_plane, sizeof(_plane));
+  // Keep the colors and then clear the display.
+  memcpy(_fadeInPixels, _pixels, sizeof(_pixels));
   clearDisplay();
 }
 
 
-// Fade in whatever is stored in the _fadeInPlane.
+// Fade in the colors kept by setupFadeIn(), from black in PwmBits steps.
 void RgbMatrix::fadeIn()
 {
-  // Loop over copy of _plane and set bits in actual _plane.
-  for (int b = 0; b < PwmBits; b++)
+  for (int step = 1; step <= PwmBits; step++)
   {
-    for (int x = 0; x < Width; x++)
-    {
-      for (int y = 0; y < Height; y++)
-      {
-        GpioPins *fiBits = &_fadeInPlane[b].row[y & 0xf].column[x];
-        GpioPins *bits = &_plane[b].row[y & 0xf].column[x];
+    memcpy(_pixels, _fadeInPixels, sizeof(_pixels));
+    scaleBytes(&_pixels[0][0].red, sizeof(_pixels), (step << 8) / PwmBits);
 
-        if (y < 16)
-        {
-          // Upper sub-panel
-	  bits->bits.r1 = fiBits->bits.r1;
-          bits->bits.g1 = fiBits->bits.g1;
-          bits->bits.b1 = fiBits->bits.b1;
-        }
-        else
-        {
-          // Lower sub-panel
-          bits->bits.r2 = fiBits->bits.r2;
-          bits->bits.g2 = fiBits->bits.g2;
-          bits->bits.b2 = fiBits->bits.b2;
-        }
-      }
+    for (int y = 0; y < Height; y++)
+    {
+      updatePlanes(0, y, Width);
     }
+
     //TODO: make this a param and/or dependent on PwmBits (longer sleep for fewer PwmBits).
     usleep(100000); // 1/10 second
   }
@@ -342,61 +449,15 @@ void RgbMatrix::wipeDown()
 {
   for (int frame = 0; frame < Height; frame++)
   {
-    //Each time through, clear the top row.
-    for (int x = 0; x < Width; x++)
-    {
-      for (int b = PwmBits - 1; b >= 0; b--)
-      {
-        GpioPins *bits = &_plane[b].row[(frame) & 0xf].column[x];
+    // Each time through, clear the top row and move it and the rows below
+    // it down by one.
+    memset(_pixels[frame], 0, sizeof(_pixels[frame]));
+    memmove(_pixels[frame + 1], _pixels[frame],
+            (Height - 1 - frame) * sizeof(_pixels[frame]));
 
-        if (frame < 16)
-        {
-	  // Upper sub-panel
-	  bits->bits.r1 = 0;
-	  bits->bits.g1 = 0;
-	  bits->bits.b1 = 0;
-	}
-	else
-	{
-	  // Lower sub-panel
-	  bits->bits.r2 = 0;
-	  bits->bits.g2 = 0;
-	  bits->bits.b2 = 0;
-	}
-      }
-    }
-
-    for (int y = Height - 1; y > frame; y--)
+    for (int y = frame; y < Height; y++)
     {
-      for (int x = 0; x < Width; x++)
-      {
-	for (int b = PwmBits - 1; b >= 0; b--)
-	{
-	  GpioPins *prevBits = &_plane[b].row[(y-1) & 0xf].column[x];
-	  GpioPins *currBits = &_plane[b].row[y & 0xf].column[x];
-
-          if (y == 16) //Special case when we cross the panels
-          {
-            currBits->bits.r2 = prevBits->bits.r1;
-            currBits->bits.g2 = prevBits->bits.g1;
-            currBits->bits.b2 = prevBits->bits.b1;
-          }
-	  else if (y < 16)
-	  {
-	    // Upper sub-panel
-	    currBits->bits.r1 = prevBits->bits.r1;
-	    currBits->bits.g1 = prevBits->bits.g1;
-	    currBits->bits.b1 = prevBits->bits.b1;
-	  }
-	  else
-	  {
-	    // Lower sub-panel
-	    currBits->bits.r2 = prevBits->bits.r2;
-	    currBits->bits.g2 = prevBits->bits.g2;
-	    currBits->bits.b2 = prevBits->bits.b2;
-	  }
-	}
-      }
+      updatePlanes(0, y, Width);
     }
 
     //TODO: make this param and/or dependent on PwmBits (longer sleep for fewer PwmBits).
@@ -405,25 +466,52 @@ void RgbMatrix::wipeDown()
 }
 
 
-void RgbMatrix::drawPixel(uint8_t x, uint8_t y, Color color)
+void RgbMatrix::drawPixel(int16_t x, int16_t y, Color color)
 {
-  if (x >= Width || y >= Height) return;
+  if (isClipped(x, y)) return;
 
-  // Four 32x32 panels would be connected like:  [>] [>]
-  //                                             [<] [<]
-  // Which would be 64 columns and 32 rows from L to R, then flipping backwards
-  // for the next 32 rows (and 64 columns).
-  if (y > 31)
+  _pixels[y][x] = color;
+
+  PlaneColor planeColor;
+  toPlaneColor(color, planeColor);
+
+  writePlanes(x, y, planeColor);
+}
+
+
+void RgbMatrix::blendPixel(int16_t x, int16_t y, Color color, uint8_t alpha)
+{
+  if (alpha == 0 || isClipped(x, y)) return;
+
+  const Color &p = _pixels[y][x];
+  Color c;
+
+  c.red = div255(color.red * alpha + p.red * (255 - alpha));
+  c.green = div255(color.green * alpha + p.green * (255 - alpha));
+  c.blue = div255(color.blue * alpha + p.blue * (255 - alpha));
+
+  drawPixel(x, y, c);
+}
+
+
+void RgbMatrix::drawHLine(int16_t x, int16_t y, int16_t w, Color color)
+{
+  if (!clipSpan(x, y, w)) return;
+
+  PlaneColor planeColor;
+  toPlaneColor(color, planeColor);
+
+  for (int16_t i = 0; i < w; i++)
   {
-    x = 127 - x;
-    y = 63 - y;
+    _pixels[y][x + i] = color;
+    writePlanes(x + i, y, planeColor);
   }
+}
 
-  // Break out values from structure
-  uint8_t red   = color.red;
-  uint8_t green = color.green;
-  uint8_t blue  = color.blue;
 
+// Convert a color to the bits it sets in each PWM bit plane.
+void RgbMatrix::toPlaneColor(Color color, PlaneColor &planeColor) const
+{
   //TODO: Adding Gamma correction slowed down the PWM and made
   //      the matrix flicker, so I'm removing it for now.
 
@@ -432,695 +520,960 @@ void RgbMatrix::drawPixel(uint8_t x, uint8_t y, Color color)
   //green = pgm_read_byte(&Gamma[green]);
   //blue  = pgm_read_byte(&Gamma[blue]);
 
-  // Scale to the number of bit planes, so MSB matches MSB of PWM.
-  red   >>= 8 - PwmBits;
-  green >>= 8 - PwmBits;
-  blue  >>= 8 - PwmBits;
+  // (A gamma curve can now be set with setColorCorrection(), which is
+  // applied here and when rows are converted, not during refresh.)
 
-  // Set RGB bits for this pixel in each PWM bit plane.
-  for (int b = 0; b < PwmBits; b++)
+  const int boards = _corrected ? ChainedBoardsCnt : 1;
+
+  for (int board = 0; board < boards; board++)
   {
-    uint8_t mask = 1 << b;
-    GpioPins *bits = &_plane[b].row[y & 0xf].column[x];
+    const Color c = _corrected ? _corrections[board].apply(color) : color;
 
-    if (y < 16)
-    {
-      // Upper sub-panel
-      bits->bits.r1 = (red & mask) == mask;
-      bits->bits.g1 = (green & mask) == mask;
-      bits->bits.b1 = (blue & mask) == mask;
-    }
-    else
+    // Scale to the number of bit planes, so MSB matches MSB of PWM.
+    const uint8_t red   = c.red   >> (8 - PwmBits);
+    const uint8_t green = c.green >> (8 - PwmBits);
+    const uint8_t blue  = c.blue  >> (8 - PwmBits);
+
+    for (int b = 0; b < PwmBits; b++)
     {
-      // Lower sub-panel
-      bits->bits.r2 = (red & mask) == mask;
-      bits->bits.g2 = (green & mask) == mask;
-      bits->bits.b2 = (blue & mask) == mask;
+      const int code = ((red >> b) & 0x1) |
+                       (((green >> b) & 0x1) << 1) |
+                       (((blue >> b) & 0x1) << 2);
+
+      planeColor.upper[board][b] = _rgbBits[0][code];
+      planeColor.lower[board][b] = _rgbBits[1][code];
     }
   }
 }
 
 
-// Bresenham's Line Algorithm
-void RgbMatrix::drawLine(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1,
-                         Color color)
+// Set RGB bits for this pixel in each PWM bit plane.
+void RgbMatrix::writePlanes(uint8_t x, uint8_t y, const PlaneColor &planeColor)
 {
-  int16_t steep = abs(y1 - y0) > abs(x1 - x0);
-
-  if (steep)
+  // Four 32x32 panels would be connected like:  [>] [>]
+  //                                             [<] [<]
+  // Which would be 64 columns and 32 rows from L to R, then flipping backwards
+  // for the next 32 rows (and 64 columns).
+  if (y > 31)
   {
-    std::swap(x0, y0);
-    std::swap(x1, y1);
+    x = 127 - x;
+    y = 63 - y;
   }
 
-  if (x0 > x1)
+  const uint8_t row = y & 0xf;
+  const bool upper = (y < 16);
+  const int board = _corrected ? x / ColsPerSubPanel : 0;
+  const uint32_t *bits = upper ? planeColor.upper[board]
+                               : planeColor.lower[board];
+  const uint32_t keep = ~(upper ? _upperBits : _lowerBits);
+
+  for (int b = 0; b < PwmBits; b++)
   {
-    std::swap(x0, x1);
-    std::swap(y0, y1);
+    GpioPins *pins = &_frame.plane[b].row[row].column[x];
+    const bool wasLit = (pins->raw & _colorBits) != 0;
+
+    pins->raw = (pins->raw & keep) | bits[b];
+
+    const bool isLit = (pins->raw & _colorBits) != 0;
+
+    if (isLit != wasLit)
+    {
+      _frame.litColumns[b][row] += isLit ? 1 : -1;
+    }
   }
+}
+
 
-  int16_t dx, dy;
-  dx = x1 - x0;
-  dy = abs(y1 - y0);
+// Position of the lowest set bit of a mask.
+static int lowestBit(uint32_t mask)
+{
+  int bit = 0;
+
+  while (bit < 31 && !(mask & (1u << bit))) bit++;
+
+  return bit;
+}
 
-  int16_t err = dx / 2;
-  int16_t ystep;
 
-  if (y0 < y1)
+void RgbMatrix::readLevels(const Frame &frame, int16_t x, int16_t y,
+                           int16_t w, uint32_t *levels) const
+{
+  // Rows below 32 are on the boards chained backwards (see writePlanes()).
+  int16_t col = x, step = 1;
+
+  if (y > 31)
   {
-    ystep = 1;
+    col = 127 - x;
+    step = -1;
+    y = 63 - y;
   }
-  else
+
+  const uint8_t row = y & 0xf;
+  const int half = (y < 16) ? 0 : 1;
+  const int redBit = lowestBit(_rgbBits[half][1]);
+  const int greenBit = lowestBit(_rgbBits[half][2]);
+  const int blueBit = lowestBit(_rgbBits[half][4]);
+
+  for (int16_t i = 0; i < w; i++)
   {
-    ystep = -1;
+    levels[i] = 0;
   }
 
-  for (; x0 <= x1; x0++)
+  // Gather one bit of each channel per plane.
+  for (int b = 0; b < PwmBits; b++)
   {
-    if (steep)
-    {
-      drawPixel(y0, x0, color);
-    }
-    else
-    {
-      drawPixel(x0, y0, color);
-    }
-
-    err -= dy;
+    const GpioPins *pins = &frame.plane[b].row[row].column[col];
 
-    if (err < 0)
+    for (int16_t i = 0; i < w; i++, pins += step)
     {
-      y0 += ystep;
-      err += dx;
+      const uint32_t raw = pins->raw;
+
+      levels[i] |= (((raw >> redBit) & 0x1) << b) |
+                   (((raw >> greenBit) & 0x1) << (b + 8)) |
+                   (((raw >> blueBit) & 0x1) << (b + 16));
     }
   }
 }
 
 
-// Draw a vertical line
-void RgbMatrix::drawVLine(uint8_t x, uint8_t y, uint8_t h, Color color)
+// Scale a level of PwmBits back to 8 bits, repeating its bits below it as
+// often as they fit so the top level is 255. Works for any PwmBits.
+static inline uint8_t expandLevel(uint32_t level)
 {
-  drawLine(x, y, x, y + h - 1, color);
+  level &= (1 << RgbMatrix::PwmBits) - 1;
+
+  uint32_t wide = 0;
+
+  for (int shift = 8 - RgbMatrix::PwmBits; shift > -RgbMatrix::PwmBits;
+       shift -= RgbMatrix::PwmBits)
+  {
+    wide |= (shift >= 0) ? level << shift : level >> -shift;
+  }
+
+  return wide;
 }
 
 
-// Draw a horizontal line
-void RgbMatrix::drawHLine(uint8_t x, uint8_t y, uint8_t w, Color color)
+// Scale levels (see readLevels()) back to 8 bit colors.
+static void expandLevels(const uint32_t *levels, Color *pixels, int16_t w)
 {
-  drawLine(x, y, x + w - 1, y, color);
+  for (int16_t i = 0; i < w; i++)
+  {
+    pixels[i].red = expandLevel(levels[i]);
+    pixels[i].green = expandLevel(levels[i] >> 8);
+    pixels[i].blue = expandLevel(levels[i] >> 16);
+  }
 }
 
 
-// Draw the outline of a rectangle (no fill)
-void RgbMatrix::drawRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, Color color)
+void RgbMatrix::writeLevels(int16_t x, int16_t y, int16_t w,
+                            const uint32_t *levels)
 {
-  drawHLine(x, y, w, color);
-  drawHLine(x, y + h - 1, w, color);
-  drawVLine(x, y, h, color);
-  drawVLine(x + w - 1, y, h, color);
+  int16_t col = x, step = 1;
+
+  if (y > 31)
+  {
+    col = 127 - x;
+    step = -1;
+    y = 63 - y;
+  }
+
+  const uint8_t row = y & 0xf;
+  const int half = (y < 16) ? 0 : 1;
+  const uint32_t keep = ~(half ? _lowerBits : _upperBits);
+  const uint32_t *bits = _rgbBits[half];
+
+  for (int b = 0; b < PwmBits; b++)
+  {
+    GpioPins *pins = &_frame.plane[b].row[row].column[col];
+    int lit = 0;
+
+    for (int16_t i = 0; i < w; i++, pins += step)
+    {
+      const uint32_t level = levels[i] >> b;
+      const uint8_t code = (level & 0x1) | ((level >> 7) & 0x2) |
+                           ((level >> 14) & 0x4);
+      const bool wasLit = (pins->raw & _colorBits) != 0;
+
+      pins->raw = (pins->raw & keep) | bits[code];
+
+      lit += ((pins->raw & _colorBits) != 0) - wasLit;
+    }
+
+    _frame.litColumns[b][row] += lit;
+  }
 }
 
 
-void RgbMatrix::fillRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, Color color)
+void RgbMatrix::updatePlanes(int16_t x, int16_t y, int16_t w)
 {
-  for (uint8_t i = x; i < x + w; i++)
+  const Color *pixels = &_pixels[y][x];
+  Color corrected[Width];
+
+  if (_corrected)
   {
-    drawVLine(i, y, h, color);
+    correctRow(x, y, pixels, w, corrected);
+    pixels = corrected;
   }
+
+  // Scale to the number of bit planes, as toPlaneColor() does.
+  const int shift = 8 - PwmBits;
+  uint32_t levels[Width];
+
+  for (int16_t i = 0; i < w; i++)
+  {
+    levels[i] = (pixels[i].red >> shift) | ((pixels[i].green >> shift) << 8) |
+                ((pixels[i].blue >> shift) << 16);
+  }
+
+  writeLevels(x, y, w, levels);
 }
 
 
-void RgbMatrix::fillScreen(Color color)
+// Recount the lit columns of every row in every bit plane.
+void RgbMatrix::countLitColumns()
 {
-  fillRect(0, 0, Width, Height, color);
+  for (int b = 0; b < PwmBits; b++)
+  {
+    for (int row = 0; row < RowsPerSubPanel; row++)
+    {
+      countLitColumns(_frame, b, row);
+    }
+  }
 }
 
 
-// Draw a rounded rectangle with radius r.
-void RgbMatrix::drawRoundRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t r,
-                              Color color)
+void RgbMatrix::countLitColumns(Frame &frame, int b, int row) const
 {
-  drawHLine(x + r    , y        , w - 2 * r, color);
-  drawHLine(x + r    , y + h - 1, w - 2 * r, color);
-  drawVLine(x        , y + r    , h - 2 * r, color);
-  drawVLine(x + w - 1, y + r    , h - 2 * r, color);
-
-  drawCircleQuadrant(x + r        , y + r        , r, 1, color);
-  drawCircleQuadrant(x + w - r - 1, y + r        , r, 2, color);
-  drawCircleQuadrant(x + w - r - 1, y + h - r - 1, r, 4, color);
-  drawCircleQuadrant(x + r        , y + h - r - 1, r, 8, color);
+  const TwoRows &rowData = frame.plane[b].row[row];
+  uint16_t count = 0;
+
+  for (int col = 0; col < ColumnCnt; col++)
+  {
+    if (rowData.column[col].raw & _colorBits) count++;
+  }
+
+  frame.litColumns[b][row] = count;
 }
 
 
-void RgbMatrix::fillRoundRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t r,
-                              Color color)
+// Draw one row of a 1-bit bitmap in two colors.
+void RgbMatrix::drawMaskRow(int16_t x, int16_t y, uint32_t mask, uint8_t w,
+                            Color color, Color background)
 {
-  fillRect(x + r, y, w - 2 * r, h, color);
+  if (y < _clip.y || y >= _clip.y + _clip.h) return;
+
+  PlaneColor fg, bg;
+  toPlaneColor(color, fg);
+  toPlaneColor(background, bg);
+
+  for (int i = 0; i < w; i++, mask >>= 1)
+  {
+    if (x + i < _clip.x || x + i >= _clip.x + _clip.w) continue;
 
-  fillCircleHalf(x + r        , y + r, r, 1, h - 2 * r - 1, color);
-  fillCircleHalf(x + w - r - 1, y + r, r, 2, h - 2 * r - 1, color);
+    _pixels[y][x + i] = (mask & 0x1) ? color : background;
+    writePlanes(x + i, y, (mask & 0x1) ? fg : bg);
+  }
 }
 
 
-// Draw the outline of a cirle (no fill) - Midpoint Circle Algorithm
-void RgbMatrix::drawCircle(uint8_t x, uint8_t y, uint8_t r, Color color)
+// Draw the glyphs of a string, converting the color to plane bits only once.
+int16_t RgbMatrix::drawString(int16_t x, int16_t y, const char *text,
+                              const Font &font, Color color, const Rect &clip)
 {
-  int16_t f = 1 - r;
-  int16_t ddFx = 1;
-  int16_t ddFy = -2 * r;
-  int16_t x1 = 0;
-  int16_t y1 = r;
+  PlaneColor planeColor;
+  toPlaneColor(color, planeColor);
 
-  drawPixel(x, y + r, color);
-  drawPixel(x, y - r, color);
-  drawPixel(x + r, y, color);
-  drawPixel(x - r, y, color);
-
-  while (x1 < y1)
+  for (const unsigned char *c = (const unsigned char *)text; *c; c++)
   {
-    if (f >= 0)
-    {
-      y1--;
-      ddFy += 2;
-      f += ddFy;
-    }
+    const Font::Glyph *glyph = font.glyph(*c);
+    if (glyph == NULL) continue;
 
-    x1++;
-    ddFx += 2;
-    f += ddFx;
+    drawGlyph(x, y, font, *glyph, color, planeColor, clip);
 
-    drawPixel(x + x1, y + y1, color);
-    drawPixel(x - x1, y + y1, color);
-    drawPixel(x + x1, y - y1, color);
-    drawPixel(x - x1, y - y1, color);
-    drawPixel(x + y1, y + x1, color);
-    drawPixel(x - y1, y + x1, color);
-    drawPixel(x + y1, y - x1, color);
-    drawPixel(x - y1, y - x1, color);
+    x += glyph->advance;
   }
+
+  return x;
 }
 
-// Draw one of the four quadrants of a circle.
-void RgbMatrix::drawCircleQuadrant(uint8_t x, uint8_t y, uint8_t r, uint8_t quadrant,
-                                   Color color)
+
+void RgbMatrix::drawGlyph(int16_t x, int16_t y, const Font &font,
+                          const Font::Glyph &glyph, Color color,
+                          const PlaneColor &planeColor, const Rect &clip)
 {
-  int16_t f = 1 - r;
-  int16_t ddFx = 1;
-  int16_t ddFy = -2 * r;
-  int16_t x1 = 0;
-  int16_t y1 = r;
+  const int16_t left = x + glyph.xOffset;
+  const int16_t top = y + glyph.yOffset;
+
+  // Columns of the glyph inside the clip rectangle.
+  uint32_t visible = 0xffffffff;
 
-  while (x1 < y1)
+  for (int i = 0; i < glyph.width; i++)
   {
-    if (f >= 0)
+    if (left + i < clip.x || left + i >= clip.x + clip.w)
     {
-      y1--;
-      ddFy += 2;
-      f += ddFy;
+      visible &= ~(1u << i);
     }
+  }
 
-    x1++;
-    ddFx += 2;
-    f += ddFx;
+  const uint32_t *rows = font.rows(glyph);
 
-    //Upper Left
-    if (quadrant & 0x1)
-    {
-      drawPixel(x - y1, y - x1, color);
-      drawPixel(x - x1, y - y1, color);
-    }
+  for (int j = 0; j < glyph.height; j++)
+  {
+    const int16_t py = top + j;
+    if (py < clip.y || py >= clip.y + clip.h) continue;
 
-    //Upper Right
-    if (quadrant & 0x2)
-    {
-      drawPixel(x + x1, y - y1, color);
-      drawPixel(x + y1, y - x1, color);
-    }
+    uint32_t line = rows[j] & visible;
 
-    //Lower Right
-    if (quadrant & 0x4)
+    for (int i = 0; line != 0; i++, line >>= 1)
     {
-      drawPixel(x + x1, y + y1, color);
-      drawPixel(x + y1, y + x1, color);
-    }
-
-    //Lower Left
-    if (quadrant & 0x8)
-    {
-      drawPixel(x - y1, y + x1, color);
-      drawPixel(x - x1, y + y1, color);
+      if (line & 0x1)
+      {
+        _pixels[py][left + i] = color;
+        writePlanes(left + i, py, planeColor);
+      }
     }
   }
 }
 
 
-void RgbMatrix::fillCircle(uint8_t x, uint8_t y, uint8_t r, Color color)
+void RgbMatrix::writeRow(int16_t x, int16_t y, const Color *pixels, int16_t w,
+                         const Color *colorKey)
 {
-  drawVLine(x, y - r, 2 * r + 1, color);
-  fillCircleHalf(x, y, r, 3, 0, color);
+  storeRow(x, y, pixels, w, colorKey);
+  convertRow(_frame, x, y, pixels, w, colorKey);
 }
 
 
-void RgbMatrix::fillCircleHalf(uint8_t x, uint8_t y, uint8_t r,
-                               uint8_t half, uint8_t stretch,
-                               Color color)
+void RgbMatrix::storeRow(int16_t x, int16_t y, const Color *pixels, int16_t w,
+                         const Color *colorKey)
 {
-  int16_t f = 1 - r;
-  int16_t ddFx = 1;
-  int16_t ddFy = -2 * r;
-  int16_t x1 = 0;
-  int16_t y1 = r;
+  if (y < 0 || y >= Height) return;
 
-  while (x1 < y1)
+  if (x < 0)
   {
-    if (f >= 0)
-    {
-      y1--;
-      ddFy += 2;
-      f += ddFy;
-    }
+    pixels -= x;
+    w += x;
+    x = 0;
+  }
 
-    x1++;
-    ddFx += 2;
-    f += ddFx;
+  if (x + w > Width) w = Width - x;
+  if (w <= 0) return;
 
-    //Left
-    if (half & 0x1)
-    {
-      drawVLine(x - x1, y - y1, 2 * y1 + 1 + stretch, color);
-      drawVLine(x - y1, y - x1, 2 * x1 + 1 + stretch, color);
-    }
+  if (colorKey == NULL)
+  {
+    memcpy(&_pixels[y][x], pixels, w * sizeof(Color));
+    return;
+  }
+
+  for (int i = 0; i < w; i++)
+  {
+    const Color &c = pixels[i];
 
-    //Right
-    if (half & 0x2)
+    if (c.red != colorKey->red || c.green != colorKey->green ||
+        c.blue != colorKey->blue)
     {
-      drawVLine(x + x1, y - y1, 2 * y1 + 1 + stretch, color);
-      drawVLine(x + y1, y - x1, 2 * x1 + 1 + stretch, color);
-   }
+      _pixels[y][x + i] = c;
+    }
   }
 }
 
-// Draw an Arc
-void RgbMatrix::drawArc(uint8_t x, uint8_t y, uint8_t r,
-                        float startAngle, float endAngle,
-                        Color color)
+
+// Convert a row of pixels into the bit planes, one plane at a time.
+void RgbMatrix::convertRow(Frame &frame, int16_t x, int16_t y,
+                           const Color *pixels, int16_t w,
+                           const Color *colorKey, int16_t *errors) const
 {
-  // Convert degrees to radians
-  float degreesPerRadian = M_PI / 180;
+  if (y < 0 || y >= Height) return;
 
-  startAngle *= degreesPerRadian;
-  endAngle *= degreesPerRadian;
-  float step = 1 * degreesPerRadian; //number of degrees per point on the arc
+  if (x < 0)
+  {
+    pixels -= x;
+    w += x;
+    x = 0;
+  }
+
+  if (x + w > Width) w = Width - x;
+  if (w <= 0) return;
 
-  float prevX = x + r * cos(startAngle);
-  float prevY = y + r * sin(startAngle);
+  // Note the transparent pixels, then scale to the number of bit planes, so
+  // MSB matches MSB of PWM.
+  uint8_t red[Width], green[Width], blue[Width];
+  bool skip[Width];
 
-  // Draw the arc
-  for (float theta = startAngle; theta < endAngle; theta += std::min(step, endAngle - theta))
+  for (int i = 0; i < w; i++)
   {
-    drawLine(prevX, prevY, x + r * cos(theta), y + r * sin(theta), color);
+    const Color &c = pixels[i];
 
-    prevX = x + r * cos(theta);
-    prevY = y + r * sin(theta);
+    skip[i] = colorKey && c.red == colorKey->red &&
+              c.green == colorKey->green && c.blue == colorKey->blue;
   }
 
-  drawLine(prevX, prevY, x + r * cos(endAngle), y + r * sin(endAngle), color);
-}
-
+  Color corrected[Width];
 
-// Draw the outline of a wedge.
-void RgbMatrix::drawWedge(uint8_t x, uint8_t y, uint8_t r,  //TODO: add inner radius
-                          float startAngle, float endAngle,
-                          Color color)
-{
-  // Convert degrees to radians
-  float degreesPerRadian = M_PI / 180;
+  if (_corrected)
+  {
+    correctRow(x, y, pixels, w, corrected);
+    pixels = corrected;
+  }
 
-  float startAngleDeg = startAngle * degreesPerRadian;
-  float endAngleDeg = endAngle * degreesPerRadian;
+  quantizeRow(x, y, pixels, w, skip, red, green, blue, errors);
 
-  uint8_t prevX = x + r * cos(startAngleDeg);
-  uint8_t prevY = y + r * sin(startAngleDeg);
+  // Rows below 32 are on the boards chained backwards (see drawPixel()).
+  int16_t col = x, step = 1;
 
-  //Special cases to overcome floating point limitations
-  if (startAngle == 90 || startAngle == 270)
+  if (y > 31)
   {
-    prevX = x;
+    col = 127 - x;
+    step = -1;
+    y = 63 - y;
   }
-  else if (startAngle == 0 || startAngle == 180 || startAngle == 360)
+
+  const uint8_t row = y & 0xf;
+  const int half = (y < 16) ? 0 : 1;
+  const uint32_t keep = ~(half ? _lowerBits : _upperBits);
+
+  for (int b = 0; b < PwmBits; b++)
   {
-    prevY = y;
-  }
+    GpioPins *pins = &frame.plane[b].row[row].column[col];
 
-  drawLine(x, y, prevX, prevY, color);
+    for (int i = 0; i < w; i++, pins += step)
+    {
+      if (skip[i]) continue;
 
-  drawArc(x, y, r, startAngle, endAngle, color);
+      const int code = ((red[i] >> b) & 0x1) |
+                       (((green[i] >> b) & 0x1) << 1) |
+                       (((blue[i] >> b) & 0x1) << 2);
 
-  prevX = x + r * cos(endAngleDeg);
-  prevY =  y + r * sin(endAngleDeg);
+      pins->raw = (pins->raw & keep) | _rgbBits[half][code];
+    }
 
-  //Special cases to overcome floating point limitations
-  if (endAngle == 90 || endAngle == 270)
-  {
-    prevX = x;
-  }
-  else if (endAngle == 0 || endAngle == 180 || endAngle == 360)
-  {
-    prevY = y;
+    countLitColumns(frame, b, row);
   }
-
-  drawLine(prevX, prevY, x, y, color);
 }
 
 
-void RgbMatrix::drawTriangle(uint8_t x1, uint8_t y1,
-                             uint8_t x2, uint8_t y2,
-                             uint8_t x3, uint8_t y3,
-                             Color color)
+void RgbMatrix::correctRow(int16_t x, int16_t y, const Color *pixels,
+                           int16_t w, Color *corrected) const
 {
-  drawLine(x1, y1, x2, y2, color);
-  drawLine(x2, y2, x3, y3, color);
-  drawLine(x3, y3, x1, y1, color);
+  for (int i = 0; i < w; i++)
+  {
+    // Rows below 32 are on the boards chained backwards (see writePlanes()).
+    const int col = (y > 31) ? 127 - (x + i) : x + i;
+
+    corrected[i] = _corrections[col / ColsPerSubPanel].apply(pixels[i]);
+  }
 }
 
 
-void RgbMatrix::fillTriangle(uint8_t x1, uint8_t y1,
-                             uint8_t x2, uint8_t y2,
-                             uint8_t x3, uint8_t y3,
-                             Color color)
+// Reduce each channel from 8 bits to PwmBits.
+void RgbMatrix::quantizeRow(int16_t x, int16_t y, const Color *pixels,
+                            int16_t w, const bool *skip, uint8_t *red,
+                            uint8_t *green, uint8_t *blue,
+                            int16_t *errors) const
 {
-  int16_t a, b, y, last;
+  const int shift = 8 - PwmBits;
+  const int top = (1 << PwmBits) - 1;
 
-  // Sort coordinates by Y order (y3 >= y2 >= y1)
-  if (y1 > y2)
+  if (_dither == DitherNone)
   {
-    std::swap(y1, y2);
-    std::swap(x1, x2);
+    for (int i = 0; i < w; i++)
+    {
+      red[i]   = pixels[i].red   >> shift;
+      green[i] = pixels[i].green >> shift;
+      blue[i]  = pixels[i].blue  >> shift;
+    }
   }
-
-  if (y2 > y3)
+  else if (_dither == DitherOrdered || _dither == DitherTemporal)
   {
-    std::swap(y3, y2);
-    std::swap(x3, x2);
+    // Adding a threshold below one step before dropping the low bits rounds
+    // up a share of the pixels in each 4x4 tile in proportion to the bits
+    // dropped, so on average the level is exact.
+    const int dx = (_dither == DitherTemporal) ? (_ditherPhase & 0x3) : 0;
+    const int dy = (_dither == DitherTemporal) ? (_ditherPhase >> 2) : 0;
+    const uint8_t *bayer = Bayer[(y + dy) & 0x3];
+
+    for (int i = 0; i < w; i++)
+    {
+      const int t = (bayer[(x + i + dx) & 0x3] << shift) >> 4;
+      int r = (pixels[i].red + t) >> shift;
+      int g = (pixels[i].green + t) >> shift;
+      int b = (pixels[i].blue + t) >> shift;
+
+      red[i]   = (r > top) ? top : r;
+      green[i] = (g > top) ? top : g;
+      blue[i]  = (b > top) ? top : b;
+    }
   }
-
-  if (y1 > y2)
+  else  // DitherDiffusion
   {
-    std::swap(y1, y2);
-    std::swap(x1, x2);
+    // Floyd-Steinberg: the error of each pixel goes 7/16 to the pixel on the
+    // right, and 3/16, 5/16 and 1/16 to the three pixels below. errors holds
+    // the errors for the row below by column, and is updated in place: the
+    // share for the pixel below and to the right is carried until the error
+    // from the row above at that column has been used. Errors are kept in
+    // 1/16ths, so even the single bit errors of 7 bit planes are spread.
+    int16_t rowErrors[ErrorsSize];
+
+    if (errors == NULL)
+    {
+      memset(rowErrors, 0, sizeof(rowErrors));
+      errors = rowErrors;
+    }
+
+    int right[3] = { 0, 0, 0 };
+    int carry[3] = { 0, 0, 0 };
+
+    for (int i = 0; i < w; i++)
+    {
+      int16_t *below = &errors[(x + i + 1) * 3];
+
+      const uint8_t in[3] = { pixels[i].red, pixels[i].green, pixels[i].blue };
+      uint8_t out[3];
+
+      for (int c = 0; c < 3; c++)
+      {
+        int want = (in[c] << 4) + right[c] + below[c];
+
+        if (want < 0) want = 0;
+        if (want > 255 << 4) want = 255 << 4;
+
+        int level = (want + (8 << shift)) >> (shift + 4);
+        if (level > top) level = top;
+
+        out[c] = level;
+
+        // Transparent pixels keep their color, so they pass no error on.
+        const int e = skip[i] ? 0 : want - (level << (shift + 4));
+
+        below[c - 3] += e * 3 / 16;
+        below[c] = e * 5 / 16 + carry[c];
+        carry[c] = e / 16;
+        right[c] = e * 7 / 16;
+      }
+
+      red[i]   = out[0];
+      green[i] = out[1];
+      blue[i]  = out[2];
+    }
   }
+}
 
-  // Handle case where all points are on the same line.
-  if(y1 == y3)
+
+// Copy a rectangle of a canvas onto the display, a row at a time.
+void RgbMatrix::blit(const Canvas &canvas, const Rect &src,
+                     int16_t dstX, int16_t dstY, const Color *colorKey)
+{
+  // Clip the source rectangle to the canvas, then where it lands on the
+  // display to the clip rectangle. In int, as the sums can overflow int16_t.
+  const int dx = dstX - src.x;
+  const int dy = dstY - src.y;
+
+  const int left = std::max(std::max<int>(src.x, 0), _clip.x - dx);
+  const int top = std::max(std::max<int>(src.y, 0), _clip.y - dy);
+  const int right = std::min(std::min<int>(src.x + src.w, canvas.width()),
+                             _clip.x + _clip.w - dx);
+  const int bottom = std::min(std::min<int>(src.y + src.h, canvas.height()),
+                              _clip.y + _clip.h - dy);
+
+  if (left >= right || top >= bottom) return;
+
+  Rect r;
+  r.x = left;
+  r.y = top;
+  r.w = right - left;
+  r.h = bottom - top;
+
+  dstX = left + dx;
+  dstY = top + dy;
+
+  // Dithering errors carried down from row to row.
+  int16_t errors[ErrorsSize];
+  memset(errors, 0, sizeof(errors));
+
+  for (int j = 0; j < r.h; j++)
   {
-    a = b = x1;
-    if(x2 < a)
-      a = x2;
-    else if(x2 > b)
-      b = x2;
-    if(x3 < a)
-      a = x3;
-    else if(x3 > b)
-      b = x3;
+    const Color *pixels = canvas.row(r.y + j) + r.x;
 
-    drawHLine(a, y1, b-a+1, color);
-    return;
+    storeRow(dstX, dstY + j, pixels, r.w, colorKey);
+    convertRow(_frame, dstX, dstY + j, pixels, r.w, colorKey, errors);
   }
+}
 
-  int16_t dx12 = x2 - x1,
-          dy12 = y2 - y1,
-          dx13 = x3 - x1,
-          dy13 = y3 - y1,
-          dx23 = x3 - x2,
-          dy23 = y3 - y2,
-          sa   = 0,
-          sb   = 0;
-
-  // For upper part of triangle, find scanline crossings for segments
-  // 1-2 and 1-3.  If y2==y3 (flat-bottomed triangle), the scanline y2
-  // is included here (and second loop will be skipped, avoiding a /0
-  // error there), otherwise scanline y2 is skipped here and handled
-  // in the second loop...which also avoids a /0 error here if y1=y2
-  // (flat-topped triangle).
-  if(y2 == y3)
-    last = y2;   // Include y2 scanline
-  else
-    last = y2-1; // Skip it
 
-  for(y = y1; y <= last; y++)
+void RgbMatrix::convertFrame(const Canvas &canvas, Frame *frame,
+                             int16_t x, int16_t y) const
+{
+  memset(&frame->plane, 0, sizeof(frame->plane));
+  memset(&frame->litColumns, 0, sizeof(frame->litColumns));
+
+  int16_t errors[ErrorsSize];
+  memset(errors, 0, sizeof(errors));
+
+  for (int j = 0; j < canvas.height(); j++)
   {
-    a   = x1 + sa / dy12;
-    b   = x1 + sb / dy13;
-    sa += dx12;
-    sb += dx13;
+    convertRow(*frame, x, y + j, canvas.row(j), canvas.width(), NULL, errors);
+  }
 
-    /* longhand:
-    a = x1 + (x2 - x1) * (y - y1) / (y2 - y1);
-    b = x1 + (x3 - x1) * (y - y1) / (y3 - y1);
-    */
+  // Each frame gets the next of the 16 positions of the Bayer pattern.
+  _ditherPhase = (_ditherPhase + 1) & 0xf;
+}
 
-    if(a > b)
-      std::swap(a,b);
 
-    drawHLine(a, y, b-a+1, color);
-  }
+// Clip a width x height image drawn at (x, y) to clip. Returns false if
+// nothing is left, else the part of the image left in src and its position
+// in x and y.
+static bool clipImage(int16_t width, int16_t height, const Rect &clip,
+                      int16_t &x, int16_t &y, Rect &src)
+{
+  src.x = 0;
+  src.y = 0;
+  src.w = width;
+  src.h = height;
 
-  // For lower part of triangle, find scanline crossings for segments
-  // 1-3 and 2-3.  This loop is skipped if y2==y3.
-  sa = dx23 * (y - y2);
-  sb = dx12 * (y - y1);
+  if (x < clip.x)
+  {
+    src.x = clip.x - x;
+    src.w -= clip.x - x;
+    x = clip.x;
+  }
 
-  for(; y<=y3; y++)
+  if (y < clip.y)
   {
-    a   = x2 + sa / dy23;
-    b   = x1 + sb / dy13;
-    sa += dx23;
-    sb += dx13;
+    src.y = clip.y - y;
+    src.h -= clip.y - y;
+    y = clip.y;
+  }
 
-    /* longhand:
-    a = x2 + (x3 - x2) * (y - y2) / (y3 - y2);
-    b = x1 + (x3 - x1) * (y - y1) / (y3 - y1);
-    */
+  if (x + src.w > clip.x + clip.w) src.w = clip.x + clip.w - x;
+  if (y + src.h > clip.y + clip.h) src.h = clip.y + clip.h - y;
+
+  return src.w > 0 && src.h > 0;
+}
+
+
+void RgbMatrix::convertFrame(const IndexedCanvas &canvas,
+                             const Palette &palette, Frame *frame,
+                             int16_t x, int16_t y) const
+{
+  memset(&frame->plane, 0, sizeof(frame->plane));
+  memset(&frame->litColumns, 0, sizeof(frame->litColumns));
 
-    if(a > b)
-      std::swap(a,b);
+  const Rect display = { 0, 0, Width, Height };
+  Rect src;
 
-    drawHLine(a, y, b-a+1, color);
+  if (clipImage(canvas.width(), canvas.height(), display, x, y, src))
+  {
+    convertIndexed(*frame, canvas, palette, src, x, y);
   }
+
+  _ditherPhase = (_ditherPhase + 1) & 0xf;
 }
 
 
-// Special method to create a color wheel on the display.
-void RgbMatrix::drawColorWheel()
+void RgbMatrix::drawSprite(const Sprite &sprite, int16_t x, int16_t y)
 {
-  int x, y, hue;
-  float dx, dy, d;
-  uint8_t sat, val;
+  if (!overlapsClip(x, y, sprite.width(), sprite.height())) return;
 
-  if (Height != Width)
-    fprintf(stderr, "Error: method drawColorWheel() only works when Height = Width.");
-  
-  float const Half = (Width - 1) / 2;
+  // The runs are clipped in int, as x + runs[k].x can overflow int16_t.
+  const int clipRight = _clip.x + _clip.w;
 
-  Color color;
-
-  for(y=0; y < Width; y++)
+  for (int16_t j = 0; j < sprite.height(); j++)
   {
-    dy = Half - (float)y;
+    int16_t py = y + j;
+    if (py < _clip.y || py >= _clip.y + _clip.h) continue;
+
+    int runCount;
+    const Sprite::Run *runs = sprite.runs(j, &runCount);
 
-    for(x=0; x < Height; x++)
+    const Color *pixels = sprite.pixels(j);
+
+    for (int k = 0; k < runCount; k++)
     {
-      dx = Half - (float)x;
-      d  = dx * dx + dy * dy;
+      const int from = std::max<int>(x + runs[k].x, _clip.x);
+      const int to = std::min<int>(x + runs[k].x + runs[k].w, clipRight);
+
+      if (from < to)
+      {
+        memcpy(&_pixels[py][from], pixels + (from - x),
+               (to - from) * sizeof(Color));
+      }
+    }
 
-      // In the circle...
-      if(d <= ((Half+1) * (Half+1)))
+    if (_corrected)
+    {
+      // The plane bits of a color differ by board.
+      for (int k = 0; k < runCount; k++)
       {
-        hue = (int)((atan2(-dy, dx) + M_PI) * 1536.0 / (M_PI * 2.0));
-        d = sqrt(d);
+        const int from = std::max<int>(x + runs[k].x, _clip.x);
+        const int to = std::min<int>(x + runs[k].x + runs[k].w, clipRight);
 
-        if(d > Half)
+        for (int px = from; px < to; px++)
         {
-          // Do a little pseudo anti-aliasing along perimeter
-          sat = 255;
-          val = (int)((1.0 - (d - Half)) * 255.0 + 0.5);
+          PlaneColor planeColor;
+          toPlaneColor(pixels[px - x], planeColor);
+          writePlanes(px, py, planeColor);
         }
-        else
+      }
+
+      continue;
+    }
+
+    // Rows below 32 are on the boards chained backwards (see drawPixel()).
+    int16_t col = 0, step = 1;
+
+    if (py > 31)
+    {
+      col = 127;
+      step = -1;
+      py = 63 - py;
+    }
+
+    const uint8_t row = py & 0xf;
+    const int half = (py < 16) ? 0 : 1;
+    const uint32_t keep = ~(half ? _lowerBits : _upperBits);
+    const uint32_t *bits = _rgbBits[half];
+
+    for (int k = 0; k < runCount; k++)
+    {
+      const int from = std::max<int>(x + runs[k].x, _clip.x);
+      const int to = std::min<int>(x + runs[k].x + runs[k].w, clipRight);
+
+      if (from >= to) continue;
+
+      for (int b = 0; b < PwmBits; b++)
+      {
+        GpioPins *pins = &_frame.plane[b].row[row].column[col + step * from];
+        const uint8_t *code = sprite.codes(b, j) + (from - x);
+        int lit = 0;
+
+        for (int i = 0; i < to - from; i++, pins += step)
         {
-          // White at center
-          sat = (int)(d / Half * 255.0 + 0.5);
-          val = 255;
+          const bool wasLit = (pins->raw & _colorBits) != 0;
+
+          pins->raw = (pins->raw & keep) | bits[code[i]];
+
+          lit += ((pins->raw & _colorBits) != 0) - wasLit;
         }
 
-        color = colorHSV(hue, sat, val);
+        _frame.litColumns[b][row] += lit;
       }
-      else
-      {
-        color.red = 0;
-        color.green = 0;
-        color.blue = 0;
-      }
-
-      drawPixel(x, y, color);
     }
   }
 }
 
-void RgbMatrix::setTextCursor(uint8_t x, uint8_t y)
-{
-  _textCursorX = x;
-  _textCursorY = y;
-}
 
-void RgbMatrix::setFontColor(Color color)
+void RgbMatrix::drawIndexed(const IndexedCanvas &canvas, const Palette &palette,
+                            int16_t x, int16_t y)
 {
-  _fontColor = color;
-}
+  Rect src;
+  if (!clipImage(canvas.width(), canvas.height(), _clip, x, y, src)) return;
 
-void RgbMatrix::setFontSize(uint8_t size)
-{
-  _fontSize = (size >= 3) ? 3 : size; //only 3 sizes for now
+  convertIndexed(_frame, canvas, palette, src, x, y);
 
-  if (_fontSize == 1)
-  {
-    _fontWidth = 3;
-    _fontHeight = 5;
-  }
-  else if (_fontSize == 2) //medium (4x6)
-  {
-    _fontWidth = 4;
-    _fontHeight = 6;
-  }
-  else if (_fontSize == 3) //large (5x7)
+  // Keep the colors of the pixels drawn.
+  for (int j = 0; j < src.h; j++)
   {
-    _fontWidth = 5;
-    _fontHeight = 7;
+    palette.map(canvas.row(src.y + j) + src.x, &_pixels[y + j][x], src.w);
   }
 }
 
-void RgbMatrix::setWordWrap(bool wrap)
-{
-  _wordWrap = wrap;
-}
 
-// Write a character using the Text cursor and stored Font settings.
-void RgbMatrix::writeChar(unsigned char c)
+// Convert part of an indexed canvas with the palette expanded into plane bits.
+void RgbMatrix::convertIndexed(Frame &frame, const IndexedCanvas &canvas,
+                               const Palette &palette, const Rect &src,
+                               int16_t x, int16_t y) const
 {
-  if (c == '\n')
+  if (_dither != DitherNone || _corrected)
   {
-    _textCursorX = 0;
-    _textCursorY += _fontHeight;
+    // Dithering and color correction work on the colors of each pixel.
+    Color colors[Width];
+    int16_t errors[ErrorsSize];
+    memset(errors, 0, sizeof(errors));
+
+    for (int j = 0; j < src.h; j++)
+    {
+      palette.map(canvas.row(src.y + j) + src.x, colors, src.w);
+      convertRow(frame, x, y + j, colors, src.w, NULL, errors);
+    }
+
+    return;
   }
-  else if (c == '\r')
+
+  // The R, G and B bits of every palette entry in every plane.
+  uint8_t codes[PwmBits][Palette::Size];
+
+  for (int i = 0; i < Palette::Size; i++)
   {
-    ; //ignore
+    const Color c = palette.color(i);
+    const uint8_t red   = c.red   >> (8 - PwmBits);
+    const uint8_t green = c.green >> (8 - PwmBits);
+    const uint8_t blue  = c.blue  >> (8 - PwmBits);
+
+    for (int b = 0; b < PwmBits; b++)
+    {
+      codes[b][i] = ((red >> b) & 0x1) |
+                    (((green >> b) & 0x1) << 1) |
+                    (((blue >> b) & 0x1) << 2);
+    }
   }
-  else
+
+  for (int j = 0; j < src.h; j++)
   {
-    putChar(_textCursorX, _textCursorY, c, _fontSize, _fontColor);
+    int16_t py = y + j;
+
+    const uint8_t *indexes = canvas.row(src.y + j) + src.x;
 
-    _textCursorX += _fontWidth + 1;
+    // Rows below 32 are on the boards chained backwards (see drawPixel()).
+    int16_t col = x, step = 1;
 
-    if (_wordWrap && (_textCursorX > (Width - _fontWidth)))
+    if (py > 31)
     {
-      _textCursorX = 0;
-      _textCursorY += _fontHeight + 1;
+      col = 127 - x;
+      step = -1;
+      py = 63 - py;
+    }
+
+    const uint8_t row = py & 0xf;
+    const int half = (py < 16) ? 0 : 1;
+    const uint32_t keep = ~(half ? _lowerBits : _upperBits);
+    const uint32_t *bits = _rgbBits[half];
+
+    for (int b = 0; b < PwmBits; b++)
+    {
+      GpioPins *pins = &frame.plane[b].row[row].column[col];
+      const uint8_t *code = codes[b];
+
+      for (int i = 0; i < src.w; i++, pins += step)
+      {
+        pins->raw = (pins->raw & keep) | bits[code[indexes[i]]];
+      }
+
+      countLitColumns(frame, b, row);
     }
   }
 }
 
-// Put a character on the display using glcd fonts.
-void RgbMatrix::putChar(uint8_t x, uint8_t y, unsigned char c, uint8_t size,
-                        Color color)
+
+void RgbMatrix::captureFrame(Frame *frame, Canvas *colors) const
 {
-  unsigned char *font = Font5x7;
-  uint8_t fontWidth = 5;
-  uint8_t fontHeight = 7;
+  memcpy(frame, &_frame, sizeof(Frame));
 
-  if (size == 1) //small (3x5)
-  {
-    font = Font3x5;
-    fontWidth = 3;
-    fontHeight = 5;
-  }
-  else if (size == 2) //medium (4x6)
-  {
-    font = Font4x6;
-    fontWidth = 4;
-    fontHeight = 6;
-  }
-  else if (size == 3) //large (5x7)
+  if (colors == NULL) return;
+
+  const int16_t w = std::min<int16_t>(colors->width(), Width);
+  const int16_t h = std::min<int16_t>(colors->height(), Height);
+
+  for (int16_t y = 0; y < h; y++)
   {
-    ; //already initialized as default
+    memcpy(colors->row(y), _pixels[y], w * sizeof(Color));
   }
+}
 
-  for (int i=0; i < fontWidth+1; i++)
+
+bool RgbMatrix::drawFrame(const Frame *frame, const Canvas *colors)
+{
+  if (colors == NULL && _corrected) return false;
+
+  memcpy(&_frame, frame, sizeof(Frame));
+
+  if (colors != NULL)
   {
-    uint8_t line;
+    const int16_t w = std::min<int16_t>(colors->width(), Width);
+    const int16_t h = std::min<int16_t>(colors->height(), Height);
 
-    if (i == fontWidth)
+    for (int16_t y = 0; y < h; y++)
     {
-      line = 0x0;
-    }
-    else
-    {
-      line = pgm_read_byte(font + ((c - 0x20) * fontWidth) + i);
+      memcpy(_pixels[y], colors->row(y), w * sizeof(Color));
     }
 
-    for (int j=0; j < fontHeight+1; j++)
-    {
-      if (line & 0x1)
-      {
-        drawPixel(x+i, y+j, color);
-      }
+    return true;
+  }
 
-      line >>= 1;
-    }
+  // The levels back in 8 bits, which are the colors without correction.
+  for (int16_t y = 0; y < Height; y++)
+  {
+    uint32_t levels[Width];
+
+    readLevels(_frame, 0, y, Width, levels);
+    expandLevels(levels, _pixels[y], Width);
   }
+
+  return true;
 }
 
 
-//Leave output in 24-bit color (#RRGGBB)
-Color RgbMatrix::colorHSV(long hue, uint8_t sat, uint8_t val)
+void RgbMatrix::readRect(const Rect &src, Canvas *canvas,
+                         int16_t dstX, int16_t dstY) const
 {
-  uint8_t r, g, b, lo;
-  uint16_t s1, v1;
-
-  // Hue
-  hue %= 1536;             // -1535 to +1535
-  if(hue < 0) hue += 1536; //     0 to +1535
+  // Clip the source rectangle to the display, then where it lands on the
+  // canvas to the canvas. In int, as the sums can overflow int16_t.
+  const int dx = dstX - src.x;
+  const int dy = dstY - src.y;
+
+  const int left = std::max(std::max<int>(src.x, 0), -dx);
+  const int top = std::max(std::max<int>(src.y, 0), -dy);
+  const int right = std::min(std::min<int>(src.x + src.w, (int)Width),
+                             canvas->width() - dx);
+  const int bottom = std::min(std::min<int>(src.y + src.h, (int)Height),
+                              canvas->height() - dy);
+
+  if (left >= right || top >= bottom) return;
+
+  Rect r;
+  r.x = left;
+  r.y = top;
+  r.w = right - left;
+  r.h = bottom - top;
+
+  dstX = left + dx;
+  dstY = top + dy;
+
+  for (int j = 0; j < r.h; j++)
+  {
+    memcpy(canvas->row(dstY + j) + dstX, &_pixels[r.y + j][r.x],
+           r.w * sizeof(Color));
+  }
+}
 
-  lo = hue & 255;  // Low byte = primary/secondary color mix
 
-  // High byte = sextant of colorwheel
-  switch(hue >> 8)
+void RgbMatrix::readFrame(Canvas *canvas, const Frame *frame) const
+{
+  if (frame == NULL)
   {
-    case 0 : r = 255;      g =  lo     ; b =   0;      break; // R to Y
-    case 1 : r = 255 - lo; g = 255     ; b =   0;      break; // Y to G
-    case 2 : r =   0;      g = 255     ; b =  lo;      break; // G to C
-    case 3 : r =   0;      g = 255 - lo; b = 255;      break; // C to B
-    case 4 : r =  lo;      g =   0     ; b = 255;      break; // B to M
-    default: r = 255;      g =   0     ; b = 255 - lo; break; // M to R
+    const Frame *shown = _shownFrame;
+    frame = shown ? shown : &_frame;
   }
 
-  // Saturation: add 1 so range is 1 to 256, which allows a bitwise right shift
-  // on the result rather than a costly divide.
-  s1 = sat + 1;
+  const int16_t w = std::min<int16_t>(canvas->width(), Width);
+  const int16_t h = std::min<int16_t>(canvas->height(), Height);
 
-  r  = 255 - (((255 - r) * s1) >> 8);
-  g  = 255 - (((255 - g) * s1) >> 8);
-  b  = 255 - (((255 - b) * s1) >> 8);
+  for (int16_t y = 0; y < h; y++)
+  {
+    uint32_t levels[Width];
 
-  // Value (brightness): Add 1, similar to above.
-  v1 = val + 1;
+    readLevels(*frame, 0, y, w, levels);
+    expandLevels(levels, canvas->row(y), w);
+  }
+}
 
-  Color c;
-  c.red   = (r * v1) >> 8;
-  c.green = (g * v1) >> 8;
-  c.blue  = (b * v1) >> 8;
 
-  return c;
+void RgbMatrix::showFrame(const Frame *frame)
+{
+  _shownFrame = frame;
+  __sync_synchronize();
+  _refreshesAtShow = _refreshes;
 }
 
 
+void RgbMatrix::waitForRefresh() const
+{
+  // Only a refresh under way when the frame changed can have the old one;
+  // later ones start with the new one.
+  const uint32_t atShow = _refreshesAtShow;
 
+  while ((atShow & 0x1) && _refreshes == atShow)
+  {
+    usleep(100);
+  }
+}
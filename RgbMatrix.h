@@ -15,23 +15,28 @@
 // for a 64x64 matrix), columns 1:64 (rows 1:32) are Left to Right across
 // the top two boards, but columns 65:128 (rows 33:64) are backwards Right
 // to Left across the bottom two boards. (Referenced by: ColumnCnt)
+//
+// Besides the bit planes that are shown, the matrix keeps the colors of
+// what is drawn (before color correction and reduction to PwmBits). Every
+// drawing function writes both. Fades and blending work on the colors, and
+// changing the color correction converts them into the bit planes again.
  
 #ifndef RPI_RGBMATRIX_H
 #define RPI_RGBMATRIX_H
 
 #include <stdint.h>
 
+#include "Canvas.h"
+#include "ColorCorrection.h"
+#include "Font.h"
 #include "GpioProxy.h"
+#include "Graphics.h"
+#include "IndexedCanvas.h"
+#include "Palette.h"
 
+class Sprite;
 
-struct Color {
-  uint8_t red;
-  uint8_t green;
-  uint8_t blue;
-};
-
-
-class RgbMatrix
+class RgbMatrix : public Graphics
 {
 public:
 
@@ -53,24 +58,51 @@ public:
   // Pulse Width Modulation (PWM) Resolution 
   static const int PwmBits = 7; //max is 7
 
+  // How colors are reduced to PwmBits when rows or frames are converted
+  // (writeRow(), blit() and convertFrame()). Dithering keeps gradients smooth
+  // with fewer bit planes, which refresh faster.
+  //   DitherNone      : the low bits are dropped (can show banding)
+  //   DitherOrdered   : a 4x4 Bayer threshold pattern
+  //   DitherDiffusion : Floyd-Steinberg error diffusion
+  //   DitherTemporal  : the Bayer pattern moves with every convertFrame(), so
+  //                     for video or animations it also averages out over time
+  enum Dither { DitherNone, DitherOrdered, DitherDiffusion, DitherTemporal };
+
 
+  // Pass NULL for io to convert frames without driving a panel.
   RgbMatrix(GpioProxy *io);
 
   // Call this in a loop to keep the matrix updated.
   void updateDisplay();
 
+  // Single pixels and shapes aren't dithered. DitherNone by default.
+  void setDither(Dither dither);
+  inline Dither dither() const { return _dither; }
+
+  // Calibrate the colors of one chained board (0 is the first in the chain).
+  // What is drawn is converted again with it, and so is everything drawn or
+  // converted afterwards.
+  void setColorCorrection(int board, const ColorCorrection &correction);
+
   // Clear the entire display
   void clearDisplay();
 
   // Clear the inside of the given rectangle.
   void clearRect(uint8_t fx, uint8_t fy, uint8_t fw, uint8_t fh);
 
-  // Fade all pixels on the display to black.
+  // Fade all pixels on the display to black, over PwmBits tenths of a second.
   void fadeDisplay();
 
   // Fade pixels inside the given rectangle to black.
   void fadeRect(uint8_t fx, uint8_t fy, uint8_t fw, uint8_t fh);
 
+  // Multiply the brightness of every pixel by factor / 256, e.g. once a
+  // frame for trails. Pixels decayed again and again end up black.
+  void decay(uint8_t factor);
+
+  // Decay the pixels inside the given rectangle (on the display).
+  void decayRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t factor);
+
   // Call this after drawing on the display and before calling fadeIn().
   // Before drawing on the display, it's best to first suspend the thread
   // that is calling updateDisplay(). After calling setupFadeIn(), resume
@@ -84,111 +116,104 @@ public:
   void wipeDown();
 
   //Drawing functions
-  void drawPixel(uint8_t x, uint8_t y, Color color);
-
-  void drawLine(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, Color color);
-
-  void drawVLine(uint8_t x, uint8_t y, uint8_t h, Color color);
-
-  void drawHLine(uint8_t x, uint8_t y, uint8_t w, Color color);
-
-  void drawRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, Color color);
-
-  void fillRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, Color color);
-
-  void fillScreen(Color color);
-
-  void drawRoundRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t r,
-                     Color color);
-
-  void fillRoundRect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t r,
-                     Color color);
-  
-  void drawCircle(uint8_t x, uint8_t y, uint8_t r, Color color);
-
-  // Draw one of the four quadrants of a cirle.
-  //   quadrant = 1 : Upper Left
-  //            = 2 : Upper Right
-  //            = 4 : Lower Right
-  //            = 8 : Lower Left
-  void drawCircleQuadrant(uint8_t x, uint8_t y, uint8_t r, uint8_t quadrant,
-                          Color color);
-
-  void fillCircle(uint8_t x, uint8_t y, uint8_t r, Color color);
-
-  // Fill one half of a cirle.
-  //   half = 1 : Left
-  //        = 2 : Right
-  //        = 3 : Both
-  //   stretch = number of pixels to stretch the circle vertically.
-  void fillCircleHalf(uint8_t x, uint8_t y, uint8_t r,
-                      uint8_t half, uint8_t stretch,
-                      Color color);
-
-  // Draw an arc.
-  //   x : Segment origin
-  //   y : Segment origin
-  //   r : Segment radius
-  //   startAngle : starting angle in degrees  (East == 0)
-  //   endAngle : ending angle in degrees
-  void drawArc(uint8_t x, uint8_t y, uint8_t r,
-               float startAngle, float endAngle,
-               Color color);
-
-  // Draw the outline of a wedge.
-  //   x : Segment origin
-  //   y : Segment origin
-  //   r : Segment radius
-  //   startAngle : starting angle in degrees  (East == 0)
-  //   endAngle : ending angle in degrees
-  void drawWedge(uint8_t x, uint8_t y, uint8_t r,
-                 float startAngle, float endAngle,
-                 Color color);
-
-  void drawTriangle(uint8_t x1, uint8_t y1,
-                    uint8_t x2, uint8_t y2,
-                    uint8_t x3, uint8_t y3,
-                    Color color);
-
-  void fillTriangle(uint8_t x1, uint8_t y1,
-                    uint8_t x2, uint8_t y2,
-                    uint8_t x3, uint8_t y3,
-                    Color color);
-
-
-  // Special method to create a color wheel on the display.
-  // Only works on displays where Height == Width.
-  void drawColorWheel();
-
-
-  // When using writeChar(), the cursor is the location where to start. 
-  void setTextCursor(uint8_t x, uint8_t y);
-
-  void setFontColor(Color color);
-
-  // Three sizes are currently available:
-  //   size = 1 : Small  (3x5)
-  //        = 2 : Medium (4x6)
-  //        = 3 : Large  (5x7)
-  void setFontSize(uint8_t size);
-
-  void setWordWrap(bool wrap);
-
-  // Write a character using the text cursor and stored Font settings.
-  void writeChar(unsigned char c);
-
-  // Put a single character on the display.
-  //   x : X for top left origin
-  //   y : Y for top left origin
-  //   c : the character to draw
-  //   size = 1 : Small  (3x5)
-  //        = 2 : Medium (4x6)
-  //        = 2 : Large  (5x7)
-  void putChar(uint8_t x, uint8_t y, unsigned char c, uint8_t size, Color color);
-
-
-  // Convert an HSV color to an RGB color.
-  Color colorHSV(long hue, uint8_t sat, uint8_t val);
+  void drawPixel(int16_t x, int16_t y, Color color);
+
+  // Blends with the color drawn at (x, y).
+  void blendPixel(int16_t x, int16_t y, Color color, uint8_t alpha);
+
+  // The color drawn at (x, y) (before color correction), which must be on
+  // the display.
+  inline Color getPixel(int16_t x, int16_t y) const { return _pixels[y][x]; }
+
+  // Copy the colors drawn in the src rectangle into canvas, with the top left
+  // of src at (dstX, dstY) (the reverse of blit()). Only the parts on the
+  // display and on the canvas are copied.
+  void readRect(const Rect &src, Canvas *canvas,
+                int16_t dstX = 0, int16_t dstY = 0) const;
+
+  // Converts the color to plane bits once for the whole span, so filled
+  // shapes cost a masked write per pixel and bit plane.
+  void drawHLine(int16_t x, int16_t y, int16_t w, Color color);
+
+  void drawMaskRow(int16_t x, int16_t y, uint32_t mask, uint8_t w,
+                   Color color, Color background);
+
+  // Convert a row of w pixels into the bit planes, starting at (x, y).
+  // Pixels of colorKey color are transparent (NULL: none are).
+  void writeRow(int16_t x, int16_t y, const Color *pixels, int16_t w,
+                const Color *colorKey = NULL);
+
+  // Copy the src rectangle of a canvas onto the display at (dstX, dstY),
+  // inside the clip rectangle.
+  // Pixels of colorKey color are transparent (NULL: none are).
+  void blit(const Canvas &canvas, const Rect &src, int16_t dstX, int16_t dstY,
+            const Color *colorKey = NULL);
+
+  // Draw an indexed canvas in the colors of palette, with its top left at
+  // (x, y), inside the clip rectangle. The palette is expanded into plane bits once for the whole
+  // canvas, so cycling colors is a palette change and one call.
+  void drawIndexed(const IndexedCanvas &canvas, const Palette &palette,
+                   int16_t x = 0, int16_t y = 0);
+
+  // Draw a sprite with its top left at (x, y), inside the clip rectangle.
+  // Draw sprites back to front to layer them (see SpriteLayer).
+  // Sprites are never dithered: with dithering on, the result differs from
+  // blit() of the same pixels and color key. Otherwise it is the same, with
+  // or without color correction.
+  void drawSprite(const Sprite &sprite, int16_t x, int16_t y);
+
+
+  // A complete set of bit planes, ready to be shown. Frames are converted
+  // ahead of time (e.g. all frames of an animation), so showing one is
+  // only a pointer swap.
+  struct Frame;
+
+  // Convert a canvas into the bit planes of frame, with the top left of the
+  // canvas at (x, y). Parts of the frame not covered by the canvas are black.
+  // What is drawn on the display is not changed.
+  void convertFrame(const Canvas &canvas, Frame *frame,
+                    int16_t x = 0, int16_t y = 0) const;
+
+  // Convert an indexed canvas in the colors of palette into frame.
+  void convertFrame(const IndexedCanvas &canvas, const Palette &palette,
+                    Frame *frame, int16_t x = 0, int16_t y = 0) const;
+
+  // Copy what is drawn on the display into frame, and its colors into the
+  // top left of colors (if not NULL).
+  void captureFrame(Frame *frame, Canvas *colors = NULL) const;
+
+  // Copy frame into what is drawn on the display (the reverse of
+  // captureFrame()), e.g. to restore a background before drawing over it.
+  // The colors are copied from colors if it isn't NULL, or else read back
+  // from the bit planes. The planes only hold colors after correction, which
+  // would be corrected again when blended with, so with color correction
+  // set colors is required: without it, nothing is drawn and false is
+  // returned.
+  bool drawFrame(const Frame *frame, const Canvas *colors = NULL);
+
+  // Read the colors of frame back out of its bit planes into the top left of
+  // canvas, as the panel shows them: color corrected, with PwmBits per
+  // channel (scaled back to 8 bits). NULL reads the frame being shown (see
+  // showFrame()). Reading doesn't hold up the refresh, so a frame changed
+  // while it is read can come out partly old and partly new.
+  void readFrame(Canvas *canvas, const Frame *frame = NULL) const;
+
+  // Show frame instead of what is drawn on the display, starting with the
+  // next refresh. The frame must stay valid while it is shown.
+  // Pass NULL to show what is drawn again.
+  void showFrame(const Frame *frame);
+
+  // A refresh under way keeps scanning the frame it started with. Call this
+  // after showFrame() before freeing or converting into the frame shown
+  // before: it waits for the refresh that was under way then, if any, to
+  // finish. Don't call it from the thread that calls updateDisplay().
+  void waitForRefresh() const;
+
+
+protected:
+
+  int16_t drawString(int16_t x, int16_t y, const char *text,
+                     const Font &font, Color color, const Rect &clip);
 
  
 private:
@@ -260,16 +285,119 @@ private:
     TwoRows row[RowsPerSubPanel];
   };
 
-  Display _plane[PwmBits];
-  Display _fadeInPlane[PwmBits]; //2nd plane for hadling fadeIn
+public:
+
+  struct Frame {
+    Display plane[PwmBits];
+
+    // Number of columns in each row (of each bit plane) with at least one
+    // color bit set. updateDisplay() skips clocking in rows that are all zero.
+    uint16_t litColumns[PwmBits][RowsPerSubPanel];
+  };
+
+private:
+
+  // What is drawn on the display.
+  Frame _frame;
+
+  // The colors of what is drawn, kept along with _frame.
+  Color _pixels[Height][Width];
+
+  // What setupFadeIn() took off the display, for fadeIn().
+  Color _fadeInPixels[Height][Width];
+
+  // Frame shown instead of _frame (see showFrame()), or NULL.
+  const Frame *volatile _shownFrame;
+
+  // Counts the starts and ends of refreshes, so it is odd while one is under
+  // way, and its value when the shown frame last changed.
+  volatile uint32_t _refreshes;
+  uint32_t _refreshesAtShow;
+
+  Dither _dither;
+
+  // Offset of the Bayer pattern, moved by convertFrame() (DitherTemporal).
+  mutable uint8_t _ditherPhase;
+
+  ColorCorrection _corrections[ChainedBoardsCnt];
+  bool _corrected;  // Any board has a correction
+
+  // Mask of the color bits (R, G and B of both sub-panels) in GpioPins.
+  uint32_t _colorBits;
+
+  // Masks of the color bits of the upper and lower sub-panel.
+  uint32_t _upperBits;
+  uint32_t _lowerBits;
+
+  // Color bits of the upper [0] and lower [1] sub-panel for each combination
+  // of a red (1), green (2) and blue (4) bit.
+  uint32_t _rgbBits[2][8];
+
+  // A color converted to the bits it sets in each bit plane, so drawing many
+  // pixels of the same color is a masked write per plane. With color
+  // correction the bits differ by board; otherwise only board 0 is set.
+  struct PlaneColor {
+    uint32_t upper[ChainedBoardsCnt][PwmBits];  // Pixel in the upper sub-panel
+    uint32_t lower[ChainedBoardsCnt][PwmBits];  // Pixel in the lower sub-panel
+  };
+
+  void toPlaneColor(Color color, PlaneColor &planeColor) const;
+
+  // Set the bits of one pixel in every bit plane. x and y must be on the display.
+  void writePlanes(uint8_t x, uint8_t y, const PlaneColor &planeColor);
+
+  // Draw the set pixels of a glyph, skipping those outside of clip.
+  void drawGlyph(int16_t x, int16_t y, const Font &font, const Font::Glyph &glyph,
+                 Color color, const PlaneColor &planeColor, const Rect &clip);
+
+  // Read the levels (0 to 2^PwmBits - 1) of w pixels from (x, y) out of the
+  // bit planes of frame, one word per pixel with red, green and blue in the
+  // low three bytes. The pixels must be on the display.
+  void readLevels(const Frame &frame, int16_t x, int16_t y, int16_t w,
+                  uint32_t *levels) const;
+
+  // Write levels (as read by readLevels()) back into the bit planes.
+  void writeLevels(int16_t x, int16_t y, int16_t w, const uint32_t *levels);
+
+  // Keep the colors of a row written into the bit planes (see writeRow()).
+  void storeRow(int16_t x, int16_t y, const Color *pixels, int16_t w,
+                const Color *colorKey);
+
+  // Convert the colors of w pixels from (x, y) into the bit planes again,
+  // like shapes (not dithered). The pixels must be on the display.
+  void updatePlanes(int16_t x, int16_t y, int16_t w);
+
+  // Recount the lit columns after bits were changed outside of drawPixel().
+  void countLitColumns();
+  void countLitColumns(Frame &frame, int b, int row) const;
+
+  // Convert a row of pixels into the bit planes of frame (see writeRow()).
+  // For DitherDiffusion, errors holds the error carried to the row below
+  // for each column (see ErrorsSize); NULL diffuses only along the row.
+  void convertRow(Frame &frame, int16_t x, int16_t y, const Color *pixels,
+                  int16_t w, const Color *colorKey, int16_t *errors = NULL) const;
+
+  // Convert the src rectangle of an indexed canvas into the bit planes of
+  // frame at (x, y) (see drawIndexed()). It must be clipped to the display.
+  void convertIndexed(Frame &frame, const IndexedCanvas &canvas,
+                      const Palette &palette, const Rect &src,
+                      int16_t x, int16_t y) const;
+
+  // Apply the color correction of the boards a row of pixels is shown on.
+  void correctRow(int16_t x, int16_t y, const Color *pixels, int16_t w,
+                  Color *corrected) const;
+
+  // Reduce a row of pixels to PwmBits per channel, dithered.
+  void quantizeRow(int16_t x, int16_t y, const Color *pixels, int16_t w,
+                   const bool *skip, uint8_t *red, uint8_t *green,
+                   uint8_t *blue, int16_t *errors) const;
+
+  // Diffused errors of each channel of a row, with a column either side.
+  static const int ErrorsSize = (Width + 2) * 3;
+
+  // Clock one row of data into the shift registers of the panel.
+  void clockIn(const TwoRows &rowData);
 
-  // Members for writing text
-  uint8_t _textCursorX, _textCursorY;
-  Color _fontColor;
-  uint8_t _fontSize;
-  uint8_t _fontWidth;
-  uint8_t _fontHeight;
-  bool _wordWrap;
 };
 
 #endif
@@ -0,0 +1,240 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// An RGB framebuffer in POSIX shared memory.
+
+#include "SharedFrameBuffer.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+const char *const SharedFrameBuffer::DefaultName = "/rgbmatrix";
+
+static const uint16_t Version = 1;
+
+// Keeps the frames after the header aligned.
+static const size_t HeaderSize = 64;
+
+
+SharedFrameBuffer::SharedFrameBuffer()
+  : _name(NULL), _data(NULL), _size(0), _header(NULL), _width(0), _height(0),
+    _lastRead(0)
+{
+}
+
+
+SharedFrameBuffer::~SharedFrameBuffer()
+{
+  close();
+}
+
+
+bool SharedFrameBuffer::create(const char *name, int16_t width, int16_t height)
+{
+  close();
+
+  if (width <= 0 || height <= 0) return false;
+
+  // Remove what a daemon that crashed left behind.
+  shm_unlink(name);
+
+  const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0666);
+  if (fd < 0)
+  {
+    perror(name);
+    return false;
+  }
+
+  // Let renderers of any user write, whatever the umask is.
+  fchmod(fd, 0666);
+
+  const size_t size = HeaderSize + 2 * width * height * sizeof(Color);
+
+  if (ftruncate(fd, size) < 0 || !map(fd, size))
+  {
+    perror(name);
+    ::close(fd);
+    shm_unlink(name);
+    return false;
+  }
+
+  ::close(fd);
+
+  // ftruncate() zeroed everything, so both frames start out black.
+  memcpy(_header->magic, "RGBS", 4);
+  _header->version = Version;
+  _header->width = width;
+  _header->height = height;
+
+  _width = width;
+  _height = height;
+  _name = strdup(name);
+  _lastRead = 0;
+
+  return true;
+}
+
+
+bool SharedFrameBuffer::attach(const char *name)
+{
+  close();
+
+  const int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0)
+  {
+    perror(name);
+    return false;
+  }
+
+  struct stat st;
+
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < HeaderSize || !map(fd, st.st_size))
+  {
+    fprintf(stderr, "%s: Not a framebuffer.\n", name);
+    ::close(fd);
+    return false;
+  }
+
+  ::close(fd);
+
+  if (memcmp(_header->magic, "RGBS", 4) != 0 || _header->version != Version ||
+      HeaderSize + 2 * _header->width * _header->height * sizeof(Color) > _size)
+  {
+    fprintf(stderr, "%s: Not a framebuffer.\n", name);
+    close();
+    return false;
+  }
+
+  _width = _header->width;
+  _height = _header->height;
+  _lastRead = _header->frameCount;
+
+  return true;
+}
+
+
+void SharedFrameBuffer::close()
+{
+  if (_data) munmap(_data, _size);
+
+  if (_name)
+  {
+    shm_unlink(_name);
+    free(_name);
+  }
+
+  _name = NULL;
+  _data = NULL;
+  _size = 0;
+  _header = NULL;
+  _width = _height = 0;
+}
+
+
+Color *SharedFrameBuffer::beginFrame()
+{
+  return frame((_header->front & 1) ^ 1);
+}
+
+
+void SharedFrameBuffer::endFrame()
+{
+  // The frame must be complete before it is published, and the sequence
+  // must be odd for as long as front and frameCount are changing.
+  __sync_synchronize();
+  _header->sequence++;
+  __sync_synchronize();
+
+  _header->front = (_header->front & 1) ^ 1;
+  _header->frameCount++;
+
+  __sync_synchronize();
+  _header->sequence++;
+  __sync_synchronize();
+}
+
+
+void SharedFrameBuffer::publish(const Canvas &canvas)
+{
+  Color *dst = beginFrame();
+
+  for (int y = 0; y < _height; y++)
+  {
+    memcpy(dst + y * _width, canvas.row(y), _width * sizeof(Color));
+  }
+
+  endFrame();
+}
+
+
+bool SharedFrameBuffer::read(Canvas *canvas)
+{
+  const size_t rowSize = _width * sizeof(Color);
+
+  // Don't spin: a renderer that crashed while publishing leaves the sequence
+  // odd for good. The next read() tries again.
+  for (int tries = 0; tries < 4; tries++)
+  {
+    const uint32_t sequence = _header->sequence;
+    __sync_synchronize();
+
+    if (sequence & 1) continue;  // Being published right now
+
+    const uint32_t count = _header->frameCount;
+    if (count == _lastRead) return false;
+
+    // Only what the renderer can't break is trusted: the size is the one
+    // the framebuffer was created with.
+    const Color *src = frame(_header->front & 1);
+
+    for (int y = 0; y < _height; y++)
+    {
+      memcpy(canvas->row(y), src + y * _width, rowSize);
+    }
+
+    // The renderer only writes into the published frame after publishing
+    // another one, so the copy is whole if nothing was published meanwhile.
+    __sync_synchronize();
+
+    if (_header->sequence == sequence)
+    {
+      _lastRead = count;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+uint32_t SharedFrameBuffer::frameCount() const
+{
+  return _header ? _header->frameCount : 0;
+}
+
+
+bool SharedFrameBuffer::map(int fd, size_t size)
+{
+  void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  if (data == MAP_FAILED) return false;
+
+  _data = data;
+  _size = size;
+  _header = (Header *)data;
+
+  return true;
+}
+
+
+Color *SharedFrameBuffer::frame(int i) const
+{
+  return (Color *)((uint8_t *)_data + HeaderSize) + i * _width * _height;
+}
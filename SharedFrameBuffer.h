@@ -0,0 +1,97 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// An RGB framebuffer in POSIX shared memory, so a renderer in another
+// process can draw on the matrix.
+//
+// Driving the panel needs root (GpioProxy maps /dev/mem), but drawing
+// doesn't. The display daemon (tools/framebuffer-daemon) creates the
+// framebuffer and shows its frames; a renderer running as any user attaches
+// to it, draws on a Canvas and publishes it. A crash in the renderer can't
+// take down the refresh loop.
+//
+// The shared memory holds two frames. The renderer writes into the one that
+// isn't published, then publishes it. A sequence number (a seqlock) is
+// bumped around every publish, so the daemon can tell if a frame was
+// published while it copied one out, and copies again.
+
+#ifndef RPI_SHAREDFRAMEBUFFER_H
+#define RPI_SHAREDFRAMEBUFFER_H
+
+#include "Canvas.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+class SharedFrameBuffer
+{
+public:
+
+  // Name of the shared memory object used by the tools.
+  static const char *const DefaultName;
+
+  SharedFrameBuffer();
+  ~SharedFrameBuffer();
+
+  // Create the shared memory (display side). Any user can attach to it.
+  bool create(const char *name, int16_t width, int16_t height);
+
+  // Attach to shared memory made by create() (renderer side).
+  bool attach(const char *name);
+
+  // Detach, and remove the shared memory if it was created here.
+  void close();
+
+  inline int16_t width() const { return _width; }
+  inline int16_t height() const { return _height; }
+
+  // Renderer side: the frame to draw into, then publish it. The frame
+  // returned is the one that isn't published, so it holds the frame before
+  // the last one.
+  Color *beginFrame();
+  void endFrame();
+
+  // Renderer side: copy a canvas of the framebuffer size and publish it.
+  void publish(const Canvas &canvas);
+
+  // Display side: copy the last published frame into canvas (of the
+  // framebuffer size). Returns false if no frame was published since the
+  // last read, or if one is being published right now.
+  bool read(Canvas *canvas);
+
+  // Number of frames published so far.
+  uint32_t frameCount() const;
+
+
+private:
+
+  SharedFrameBuffer(const SharedFrameBuffer &);
+  SharedFrameBuffer &operator=(const SharedFrameBuffer &);
+
+  struct Header {
+    char magic[4];              // "RGBS"
+    uint16_t version;
+    uint16_t width;
+    uint16_t height;
+    uint16_t reserved;
+    volatile uint32_t sequence;  // Odd while a frame is being published
+    volatile uint32_t front;     // Index of the published frame (0 or 1)
+    volatile uint32_t frameCount;
+  };
+
+  bool map(int fd, size_t size);
+
+  Color *frame(int i) const;
+
+  char *_name;   // Set if the shared memory was created here
+  void *_data;
+  size_t _size;
+  Header *_header;
+  int16_t _width, _height;
+
+  uint32_t _lastRead;  // frameCount of the last frame read
+};
+
+#endif
@@ -0,0 +1,83 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A small image precompiled for drawing on the RGB Matrix.
+
+#include "Sprite.h"
+
+#include <algorithm>
+
+
+Sprite::Sprite(const Canvas &image, const Color *colorKey, const Rect *src)
+{
+  Rect r = { 0, 0, image.width(), image.height() };
+
+  if (src != NULL)
+  {
+    // Only the part of src on the image, in int as the sums can overflow
+    // int16_t.
+    const int left = std::max<int>(src->x, 0);
+    const int top = std::max<int>(src->y, 0);
+    const int right = std::min<int>(src->x + src->w, image.width());
+    const int bottom = std::min<int>(src->y + src->h, image.height());
+
+    r.x = left;
+    r.y = top;
+    r.w = std::max(right - left, 0);
+    r.h = std::max(bottom - top, 0);
+  }
+
+  _width = r.w;
+  _height = r.h;
+
+  const int PwmBits = RgbMatrix::PwmBits;
+
+  _codes.resize(PwmBits * _width * _height);
+  _pixels.resize(_width * _height);
+  _rowRuns.push_back(0);
+
+  for (int j = 0; j < _height; j++)
+  {
+    const Color *row = image.row(r.y + j) + r.x;
+    Run run = { 0, 0 };
+
+    for (int i = 0; i < _width; i++)
+    {
+      const Color &c = row[i];
+
+      _pixels[j * _width + i] = c;
+
+      // Scale to the number of bit planes, as the matrix does.
+      const uint8_t red   = c.red   >> (8 - PwmBits);
+      const uint8_t green = c.green >> (8 - PwmBits);
+      const uint8_t blue  = c.blue  >> (8 - PwmBits);
+
+      for (int b = 0; b < PwmBits; b++)
+      {
+        _codes[(b * _height + j) * _width + i] = ((red >> b) & 0x1) |
+                                                 (((green >> b) & 0x1) << 1) |
+                                                 (((blue >> b) & 0x1) << 2);
+      }
+
+      const bool transparent = colorKey != NULL && c.red == colorKey->red &&
+                               c.green == colorKey->green &&
+                               c.blue == colorKey->blue;
+
+      if (!transparent)
+      {
+        if (run.w == 0) run.x = i;
+        run.w++;
+      }
+      else if (run.w > 0)
+      {
+        _runs.push_back(run);
+        run.w = 0;
+      }
+    }
+
+    if (run.w > 0) _runs.push_back(run);
+
+    _rowRuns.push_back(_runs.size());
+  }
+}
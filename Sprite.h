@@ -0,0 +1,73 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A small image (icon, cursor, game character) precompiled for drawing on
+// the RGB Matrix with RgbMatrix::drawSprite().
+//
+// When a sprite is made, each pixel is reduced to the R, G and B bits it
+// has in every bit plane, and the opaque pixels of each row are found as
+// runs. Drawing is then a masked write of the plane words of each run,
+// with no color conversion or per pixel transparency test, so moving many
+// sprites every frame is cheap. Sprites aren't dithered (like shapes).
+
+#ifndef RPI_SPRITE_H
+#define RPI_SPRITE_H
+
+#include "Canvas.h"
+#include "Graphics.h"
+#include "RgbMatrix.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+
+class Sprite
+{
+public:
+
+  // A row's opaque pixels, from x to x + w - 1.
+  struct Run {
+    int16_t x;
+    int16_t w;
+  };
+
+
+  // Make a sprite from the src rectangle of image (NULL: all of it).
+  // Pixels of colorKey color are transparent (NULL: none are).
+  Sprite(const Canvas &image, const Color *colorKey = NULL,
+         const Rect *src = NULL);
+
+  inline int16_t width() const { return _width; }
+  inline int16_t height() const { return _height; }
+
+  // The opaque runs of row y. Sets count to how many there are.
+  inline const Run *runs(int16_t y, int *count) const
+  {
+    *count = _rowRuns[y + 1] - _rowRuns[y];
+    return (*count > 0) ? &_runs[_rowRuns[y]] : NULL;
+  }
+
+  // The R (1), G (2) and B (4) bits of each pixel of row y in bit plane b.
+  inline const uint8_t *codes(int b, int16_t y) const
+  {
+    return &_codes[(b * _height + y) * _width];
+  }
+
+  // The colors of row y (used when the matrix has color correction).
+  inline const Color *pixels(int16_t y) const { return &_pixels[y * _width]; }
+
+
+private:
+
+  int16_t _width;
+  int16_t _height;
+
+  std::vector<Run> _runs;
+  std::vector<int> _rowRuns;  // Index of the first run of each row (and end)
+  std::vector<uint8_t> _codes;
+  std::vector<Color> _pixels;
+};
+
+#endif
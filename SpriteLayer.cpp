@@ -0,0 +1,63 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A set of sprites placed on the RGB Matrix, drawn in z order.
+
+#include "SpriteLayer.h"
+
+
+SpriteLayer::SpriteLayer(RgbMatrix *m) : _matrix(m)
+{
+}
+
+
+int SpriteLayer::add(const Sprite *sprite, int16_t x, int16_t y, int z)
+{
+  Placement p;
+  p.sprite = sprite;
+  p.x = x;
+  p.y = y;
+  p.z = z;
+  p.visible = true;
+
+  _placements.push_back(p);
+  _order.push_back(_placements.size() - 1);
+
+  return _placements.size() - 1;
+}
+
+
+void SpriteLayer::draw()
+{
+  // Sort back to front. The order rarely changes between frames, so an
+  // insertion sort of last frame's order is about one pass. Ties go by
+  // index, so sprites of equal z keep the order they were added in.
+  for (size_t i = 1; i < _order.size(); i++)
+  {
+    const int index = _order[i];
+    const int z = _placements[index].z;
+    size_t j = i;
+
+    for (; j > 0; j--)
+    {
+      const Placement &before = _placements[_order[j - 1]];
+
+      if (before.z < z || (before.z == z && _order[j - 1] < index)) break;
+
+      _order[j] = _order[j - 1];
+    }
+
+    _order[j] = index;
+  }
+
+  for (size_t i = 0; i < _order.size(); i++)
+  {
+    const Placement &p = _placements[_order[i]];
+
+    if (p.visible && p.sprite != NULL)
+    {
+      _matrix->drawSprite(*p.sprite, p.x, p.y);
+    }
+  }
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A set of sprites placed on the RGB Matrix, drawn in z order.
+//
+// Each frame, draw (or convert) the background, move the sprites by
+// changing their positions, and call draw(). Sprites with a higher z are
+// drawn over those with a lower one; equal z keeps the order they were
+// added in.
+
+#ifndef RPI_SPRITELAYER_H
+#define RPI_SPRITELAYER_H
+
+#include "RgbMatrix.h"
+#include "Sprite.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+
+class SpriteLayer
+{
+public:
+
+  struct Placement {
+    const Sprite *sprite;
+    int16_t x;          // Position of the top left of the sprite
+    int16_t y;
+    int z;              // Drawing order: higher is in front
+    bool visible;
+  };
+
+
+  SpriteLayer(RgbMatrix *m);
+
+  // Place a sprite. Returns the index of the placement, which is used to
+  // move it later. The sprite is not copied, and can be placed many times.
+  int add(const Sprite *sprite, int16_t x, int16_t y, int z = 0);
+
+  inline Placement &placement(int index) { return _placements[index]; }
+  inline int placementCount() const { return _placements.size(); }
+
+  inline void moveTo(int index, int16_t x, int16_t y)
+  {
+    _placements[index].x = x;
+    _placements[index].y = y;
+  }
+
+  // Draw the visible sprites on the matrix, back to front.
+  void draw();
+
+
+private:
+
+  RgbMatrix *const _matrix;
+  std::vector<Placement> _placements;
+
+  // Placement indexes back to front, kept from one draw() to the next.
+  std::vector<int> _order;
+};
+
+#endif
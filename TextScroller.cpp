@@ -0,0 +1,175 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Scroll a line of text horizontally through a window on the matrix or a
+// Canvas.
+
+#include "TextScroller.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+
+// Thresholds for the fractional position, in an order that spreads the
+// rounding up evenly over four frames.
+static const float SubPixelThreshold[4] = { 0.0, 0.5, 0.25, 0.75 };
+
+
+TextScroller::TextScroller(Graphics *g, const Rect &window)
+  : _graphics(g), _window(window), _rowWords(1), _textWidth(0),
+    _stripWidth(std::max<int>(window.w, 1)), _speed(1.0), _position(0.0),
+    _subPixel(true), _frame(0), _shownOffset(-1)
+{
+  Color white = { 255, 255, 255 };
+  Color black = { 0, 0, 0 };
+
+  _color = white;
+  _background = black;
+}
+
+
+void TextScroller::setText(const char *text, const Font &font)
+{
+  _textWidth = font.measure(text);
+  // At least 1, so an empty text in an empty window still has a position.
+  _stripWidth = std::max(_textWidth + _window.w, 1);
+  _rowWords = (_textWidth + 31) / 32 + 1;
+
+  _bitmap.assign(_rowWords * _window.h, 0);
+
+  int pen = 0;
+
+  for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+  {
+    const Font::Glyph *glyph = font.glyph(*c);
+    if (glyph == NULL) continue;
+
+    const uint32_t *rows = font.rows(*glyph);
+
+    for (int j = 0; j < glyph->height; j++)
+    {
+      const int y = glyph->yOffset + j;
+      if (y < 0 || y >= _window.h) continue;
+
+      for (int i = 0; i < glyph->width; i++)
+      {
+        const int x = pen + glyph->xOffset + i;
+        if (x < 0 || x >= _textWidth) continue;
+
+        if (rows[j] & (1u << i))
+        {
+          _bitmap[y * _rowWords + (x >> 5)] |= 1u << (x & 31);
+        }
+      }
+    }
+
+    pen += glyph->advance;
+  }
+
+  // Start with the text just outside the right edge of the window.
+  _position = _textWidth;
+  _shownOffset = -1;
+}
+
+
+void TextScroller::setColors(Color color, Color background)
+{
+  _color = color;
+  _background = background;
+  _shownOffset = -1;
+}
+
+
+void TextScroller::setSpeed(float pixelsPerFrame)
+{
+  _speed = pixelsPerFrame;
+}
+
+
+void TextScroller::setSubPixel(bool subPixel)
+{
+  _subPixel = subPixel;
+}
+
+
+void TextScroller::step()
+{
+  _position = fmodf(_position + _speed, _stripWidth);
+  if (_position < 0) _position += _stripWidth;
+
+  float threshold = 0.0;
+
+  if (_subPixel)
+  {
+    threshold = SubPixelThreshold[_frame++ & 0x3];
+  }
+
+  const int offset = (int)floorf(_position + threshold) % _stripWidth;
+
+  if (offset != _shownOffset)
+  {
+    _shownOffset = offset;
+    draw();
+  }
+}
+
+
+void TextScroller::draw()
+{
+  if (_shownOffset < 0)
+  {
+    _shownOffset = (int)_position % _stripWidth;
+  }
+
+  for (int j = 0; j < _window.h; j++)
+  {
+    for (int x = 0; x < _window.w; x += 32)
+    {
+      const int n = (_window.w - x < 32) ? (_window.w - x) : 32;
+      const uint32_t mask = rowBits(j, _shownOffset + x, n);
+
+      _graphics->drawMaskRow(_window.x + x, _window.y + j, mask, n,
+                             _color, _background);
+    }
+  }
+}
+
+
+uint32_t TextScroller::rowBits(int j, int start, int n) const
+{
+  if (_bitmap.empty()) return 0;
+
+  const uint32_t *row = &_bitmap[j * _rowWords];
+  start %= _stripWidth;
+
+  const uint32_t lowBits = (n == 32) ? 0xffffffff : ((1u << n) - 1);
+
+  if (start + n <= _textWidth)
+  {
+    // The common case: one shift of two words.
+    const int word = start >> 5;
+    const int shift = start & 31;
+
+    uint32_t bits = row[word] >> shift;
+    if (shift) bits |= row[word + 1] << (32 - shift);
+
+    return bits & lowBits;
+  }
+
+  // Near the end of the text: the gap and the start of the text again.
+  uint32_t bits = 0;
+
+  for (int i = 0; i < n; i++)
+  {
+    const int x = (start + i) % _stripWidth;
+
+    if (x < _textWidth && (row[x >> 5] & (1u << (x & 31))))
+    {
+      bits |= 1u << i;
+    }
+  }
+
+  return bits;
+}
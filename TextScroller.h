@@ -0,0 +1,78 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Scroll a line of text horizontally through a window on the matrix or a
+// Canvas (a marquee or ticker).
+//
+// The text is rendered once into a 1-bit bitmap when it is set. Each frame
+// only the scroll offset changes, and the window is redrawn from the bitmap
+// one row mask at a time; nothing is redrawn when the offset doesn't change.
+//
+// Speeds below one pixel per frame move smoothly with sub-pixel positioning:
+// the fractional part of the position is dithered over time, so the text
+// alternates between the two nearest pixel offsets.
+
+#ifndef RPI_TEXTSCROLLER_H
+#define RPI_TEXTSCROLLER_H
+
+#include "Font.h"
+#include "Graphics.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+
+class TextScroller
+{
+public:
+
+  // The text scrolls through window (in display coordinates).
+  TextScroller(Graphics *g, const Rect &window);
+
+  // Render the text into the bitmap and restart scrolling. The text enters
+  // the window from the right and is followed by a gap as wide as the window.
+  void setText(const char *text, const Font &font);
+
+  void setColors(Color color, Color background);
+
+  // Pixels per frame; negative values scroll to the right.
+  void setSpeed(float pixelsPerFrame);
+
+  // Dither the fractional position over frames for smooth slow scrolling.
+  void setSubPixel(bool subPixel);
+
+  // Advance by one frame and redraw the window if the offset changed.
+  void step();
+
+  // Redraw the window at the current offset.
+  void draw();
+
+
+private:
+
+  // Bits start .. start+n-1 (n <= 32) of row j, wrapping around the strip.
+  uint32_t rowBits(int j, int start, int n) const;
+
+  Graphics *const _graphics;
+  Rect _window;
+
+  // Row-major bitmap of the rendered text, _rowWords words per row, plus one
+  // spare word per row so reading 32 bits from any offset stays in bounds.
+  std::vector<uint32_t> _bitmap;
+  int _rowWords;
+  int _textWidth;
+  int _stripWidth;  // _textWidth plus the gap
+
+  Color _color;
+  Color _background;
+
+  float _speed;
+  float _position;
+  bool _subPixel;
+  uint8_t _frame;
+  int _shownOffset;
+};
+
+#endif
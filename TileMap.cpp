@@ -0,0 +1,112 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A scrolling background made of a grid of tiles.
+
+#include "TileMap.h"
+
+#include <algorithm>
+
+
+TileMap::TileMap(RgbMatrix *m, const TileSet *tiles, int columns, int rows)
+  : _matrix(m), _tiles(tiles), _columns(columns), _rows(rows),
+    _cells(columns * rows, (uint16_t)Empty)
+{
+  _viewport.x = 0;
+  _viewport.y = 0;
+  _viewport.w = m->width();
+  _viewport.h = m->height();
+  _scrollX = 0;
+  _scrollY = 0;
+  _wrap = false;
+
+  Color black = { 0, 0, 0 };
+  _hasBackground = true;
+  _background = black;
+}
+
+
+void TileMap::setViewport(const Rect &viewport)
+{
+  _viewport = viewport;
+}
+
+
+void TileMap::setBackground(const Color *color)
+{
+  _hasBackground = color != NULL;
+  if (color) _background = *color;
+}
+
+
+uint16_t TileMap::cell(int32_t column, int32_t row) const
+{
+  if (_wrap)
+  {
+    column %= _columns;
+    if (column < 0) column += _columns;
+
+    row %= _rows;
+    if (row < 0) row += _rows;
+  }
+  else if (column < 0 || row < 0 || column >= _columns || row >= _rows)
+  {
+    return Empty;
+  }
+
+  return _cells[row * _columns + column];
+}
+
+
+void TileMap::draw()
+{
+  const int16_t tw = _tiles->tileWidth();
+  const int16_t th = _tiles->tileHeight();
+
+  if (tw <= 0 || th <= 0 || _columns <= 0 || _rows <= 0) return;
+
+  // Only draw inside both the viewport and the clip rectangle.
+  const Rect saved = _matrix->clipRect();
+  Rect clip;
+
+  clip.x = std::max(saved.x, _viewport.x);
+  clip.y = std::max(saved.y, _viewport.y);
+  clip.w = std::min(saved.x + saved.w, _viewport.x + _viewport.w) - clip.x;
+  clip.h = std::min(saved.y + saved.h, _viewport.y + _viewport.h) - clip.y;
+
+  if (clip.w <= 0 || clip.h <= 0) return;
+
+  _matrix->setClipRect(clip);
+
+  // Cover what was drawn before where no tile pixel will be.
+  if (_hasBackground)
+  {
+    _matrix->fillRect(clip.x, clip.y, clip.w, clip.h, _background);
+  }
+
+  // The tile at the top left of the clip rectangle, and how far into it.
+  const int32_t left = _scrollX + clip.x - _viewport.x;
+  const int32_t top = _scrollY + clip.y - _viewport.y;
+  const int32_t firstColumn = floorDiv(left, tw);
+  const int32_t firstRow = floorDiv(top, th);
+  const int32_t offsetX = left - firstColumn * tw;
+  const int32_t offsetY = top - firstRow * th;
+
+  for (int32_t row = firstRow, y = clip.y - offsetY;
+       y < clip.y + clip.h; row++, y += th)
+  {
+    for (int32_t column = firstColumn, x = clip.x - offsetX;
+         x < clip.x + clip.w; column++, x += tw)
+    {
+      const uint16_t index = cell(column, row);
+
+      if (index != Empty && index < _tiles->tileCount())
+      {
+        _matrix->drawSprite(_tiles->tile(index), x, y);
+      }
+    }
+  }
+
+  _matrix->setClipRect(saved);
+}
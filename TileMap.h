@@ -0,0 +1,101 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// A scrolling background made of a grid of tiles, for content much larger
+// than the display (maps, long banners).
+//
+// The map only stores a tile index for each cell. The tiles are already in
+// bit plane form (see TileSet), so scrolling is changing the scroll offset
+// and calling draw(), which writes the visible parts of the tiles into the
+// bit planes without converting any colors. Sprites can then be drawn
+// over it (see SpriteLayer) each frame.
+
+#ifndef RPI_TILEMAP_H
+#define RPI_TILEMAP_H
+
+#include "Graphics.h"
+#include "RgbMatrix.h"
+#include "TileSet.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+
+class TileMap
+{
+public:
+
+  // Index of a cell with no tile (only the background is drawn there).
+  static const uint16_t Empty = 0xffff;
+
+
+  // A map of columns x rows cells, all Empty, shown on the whole display.
+  // The tiles are not copied.
+  TileMap(RgbMatrix *m, const TileSet *tiles, int columns, int rows);
+
+  inline int columns() const { return _columns; }
+  inline int rows() const { return _rows; }
+
+  inline void setTile(int column, int row, uint16_t index)
+  {
+    _cells[row * _columns + column] = index;
+  }
+
+  inline uint16_t tile(int column, int row) const
+  {
+    return _cells[row * _columns + column];
+  }
+
+  // The part of the display the map is shown in.
+  void setViewport(const Rect &viewport);
+
+  // The pixel of the map shown at the top left of the viewport.
+  inline void setScroll(int32_t x, int32_t y)
+  {
+    _scrollX = x;
+    _scrollY = y;
+  }
+
+  inline int32_t scrollX() const { return _scrollX; }
+  inline int32_t scrollY() const { return _scrollY; }
+
+  // With wrap, the map repeats in every direction, so it can scroll
+  // forever; otherwise only the background is drawn beyond its edges.
+  inline void setWrap(bool wrap) { _wrap = wrap; }
+
+  // The color the viewport is filled with before the tiles are drawn, which
+  // shows in Empty cells and the transparent pixels of tiles. Defaults to
+  // black. With NULL nothing is filled, to show the map over what is already
+  // drawn; then the caller must clear the viewport before each draw(), or
+  // what was drawn there before stays.
+  void setBackground(const Color *color);
+
+  // Draw the background and the tiles visible in the viewport (and the clip
+  // rectangle).
+  void draw();
+
+
+private:
+
+  // The tile index of a cell, which may be off the map.
+  uint16_t cell(int32_t column, int32_t row) const;
+
+  RgbMatrix *const _matrix;
+  const TileSet *const _tiles;
+
+  const int _columns;
+  const int _rows;
+  std::vector<uint16_t> _cells;
+
+  Rect _viewport;
+  int32_t _scrollX;
+  int32_t _scrollY;
+  bool _wrap;
+
+  bool _hasBackground;
+  Color _background;
+};
+
+#endif
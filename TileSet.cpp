@@ -0,0 +1,24 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// The tiles of a TileMap, precompiled into bit plane form.
+
+#include "TileSet.h"
+
+
+TileSet::TileSet(const Canvas &sheet, int16_t tileWidth, int16_t tileHeight,
+                 const Color *colorKey)
+  : _tileWidth(tileWidth), _tileHeight(tileHeight)
+{
+  if (tileWidth <= 0 || tileHeight <= 0) return;
+
+  for (int16_t y = 0; y + tileHeight <= sheet.height(); y += tileHeight)
+  {
+    for (int16_t x = 0; x + tileWidth <= sheet.width(); x += tileWidth)
+    {
+      const Rect src = { x, y, tileWidth, tileHeight };
+      _tiles.push_back(Sprite(sheet, colorKey, &src));
+    }
+  }
+}
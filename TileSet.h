@@ -0,0 +1,46 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// The tiles of a TileMap, cut from a sheet of equally sized images and
+// precompiled into bit plane form (as Sprites) once, so showing them never
+// converts colors again.
+
+#ifndef RPI_TILESET_H
+#define RPI_TILESET_H
+
+#include "Canvas.h"
+#include "Sprite.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+
+class TileSet
+{
+public:
+
+  // Cut sheet into tiles of tileWidth x tileHeight, numbered left to right
+  // and top to bottom. Pixels of colorKey color are transparent (NULL: none
+  // are), which shows the background of the map there, or with no
+  // background what is behind the map (see TileMap::setBackground()).
+  TileSet(const Canvas &sheet, int16_t tileWidth, int16_t tileHeight,
+          const Color *colorKey = NULL);
+
+  inline int16_t tileWidth() const { return _tileWidth; }
+  inline int16_t tileHeight() const { return _tileHeight; }
+
+  inline int tileCount() const { return _tiles.size(); }
+  inline const Sprite &tile(int i) const { return _tiles[i]; }
+
+
+private:
+
+  int16_t _tileWidth;
+  int16_t _tileHeight;
+
+  std::vector<Sprite> _tiles;
+};
+
+#endif
@@ -0,0 +1,432 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Play a stream of video frames read from a file descriptor.
+
+#include "VideoStream.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+
+// How often a blocked read checks whether the stream was closed.
+static const int PollTimeoutMs = 100;
+
+
+static void addNanos(struct timespec *t, long ns)
+{
+  t->tv_nsec += ns;
+
+  while (t->tv_nsec >= 1000000000L)
+  {
+    t->tv_sec++;
+    t->tv_nsec -= 1000000000L;
+  }
+}
+
+
+static bool isBefore(const struct timespec &a, const struct timespec &b)
+{
+  return a.tv_sec < b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_nsec < b.tv_nsec);
+}
+
+
+VideoStream::VideoStream(RgbMatrix *matrix)
+  : _matrix(matrix), _fd(-1), _format(FormatPpm), _width(0), _height(0),
+    _fit(FitCrop), _dropLate(true), _threadRunning(false),
+    _bufferPos(0), _bufferEnd(0), _waiting(NULL), _spare(NULL),
+    _ended(true), _stopping(false), _dropped(0), _showing(NULL),
+    _scaled(new Canvas(RgbMatrix::Width, RgbMatrix::Height)),
+    _buffers(matrix), _periodNs(0), _shown(0)
+{
+  pthread_mutex_init(&_mutex, NULL);
+  pthread_cond_init(&_frameReady, NULL);
+  pthread_cond_init(&_frameTaken, NULL);
+}
+
+
+VideoStream::~VideoStream()
+{
+  close();
+
+  delete _scaled;
+
+  pthread_cond_destroy(&_frameTaken);
+  pthread_cond_destroy(&_frameReady);
+  pthread_mutex_destroy(&_mutex);
+}
+
+
+bool VideoStream::open(int fd, Format format, int16_t width, int16_t height)
+{
+  close();
+
+  if (format == FormatRaw && (width <= 0 || height <= 0))
+  {
+    fprintf(stderr, "VideoStream: Raw frames need a width and height.\n");
+    return false;
+  }
+
+  _fd = fd;
+  _format = format;
+  _width = width;
+  _height = height;
+
+  _bufferPos = _bufferEnd = 0;
+  _ended = false;
+  _stopping = false;
+  _dropped = 0;
+  _shown = 0;
+  _deadline.tv_sec = 0;
+  _deadline.tv_nsec = 0;
+
+  if (pthread_create(&_thread, NULL, readerThread, this) != 0)
+  {
+    perror("VideoStream");
+    _ended = true;
+    return false;
+  }
+
+  _threadRunning = true;
+  return true;
+}
+
+
+void VideoStream::close()
+{
+  if (_threadRunning)
+  {
+    pthread_mutex_lock(&_mutex);
+    _stopping = true;
+    pthread_cond_broadcast(&_frameTaken);
+    pthread_mutex_unlock(&_mutex);
+
+    pthread_join(_thread, NULL);
+    _threadRunning = false;
+  }
+
+  // The planes are freed or converted into again after this.
+  _buffers.release();
+
+  delete _waiting;
+  delete _spare;
+  delete _showing;
+
+  _waiting = _spare = _showing = NULL;
+  _ended = true;
+}
+
+
+void VideoStream::setFit(Fit fit)
+{
+  _fit = fit;
+}
+
+
+void VideoStream::setFilter(Resampler::Filter filter)
+{
+  _resampler.setFilter(filter);
+}
+
+
+void VideoStream::setFrameRate(float fps)
+{
+  _periodNs = (fps > 0) ? (long)(1000000000.0 / fps) : 0;
+}
+
+
+void VideoStream::setDropLate(bool dropLate)
+{
+  pthread_mutex_lock(&_mutex);
+  _dropLate = dropLate;
+  pthread_cond_broadcast(&_frameTaken);
+  pthread_mutex_unlock(&_mutex);
+}
+
+
+bool VideoStream::showNext()
+{
+  if (_periodNs)
+  {
+    if (_deadline.tv_sec == 0)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &_deadline);
+    }
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &_deadline, NULL) == EINTR)
+    {
+      ;
+    }
+  }
+
+  // Take the newest complete frame.
+  pthread_mutex_lock(&_mutex);
+
+  while (_waiting == NULL && !_ended)
+  {
+    pthread_cond_wait(&_frameReady, &_mutex);
+  }
+
+  if (_waiting == NULL)
+  {
+    pthread_mutex_unlock(&_mutex);
+    return false;
+  }
+
+  // Give the reader back the buffer of the frame shown before.
+  if (_spare == NULL)
+  {
+    _spare = _showing;
+  }
+  else
+  {
+    delete _showing;
+  }
+
+  _showing = _waiting;
+  _waiting = NULL;
+
+  pthread_cond_signal(&_frameTaken);
+  pthread_mutex_unlock(&_mutex);
+
+  convertFrame(*_showing, _buffers.beginFrame());
+  _buffers.endFrame();
+  _shown++;
+
+  if (_periodNs)
+  {
+    addNanos(&_deadline, _periodNs);
+
+    // If showing fell behind, start again from now instead of rushing
+    // through the frames to catch up.
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (isBefore(_deadline, now)) _deadline = now;
+  }
+
+  return true;
+}
+
+
+void *VideoStream::readerThread(void *stream)
+{
+  ((VideoStream *)stream)->readFrames();
+  return NULL;
+}
+
+
+void VideoStream::readFrames()
+{
+  Canvas *reading = NULL;
+
+  while (true)
+  {
+    int16_t width, height;
+
+    if (!readFrameSize(&width, &height)) break;
+
+    if (reading == NULL)
+    {
+      pthread_mutex_lock(&_mutex);
+      reading = _spare;
+      _spare = NULL;
+      pthread_mutex_unlock(&_mutex);
+    }
+
+    if (reading && (reading->width() != width || reading->height() != height))
+    {
+      delete reading;
+      reading = NULL;
+    }
+
+    if (reading == NULL) reading = new Canvas(width, height);
+
+    if (!readFrame(reading)) break;
+
+    pthread_mutex_lock(&_mutex);
+
+    while (_waiting && !_dropLate && !_stopping)
+    {
+      pthread_cond_wait(&_frameTaken, &_mutex);
+    }
+
+    if (_stopping)
+    {
+      pthread_mutex_unlock(&_mutex);
+      break;
+    }
+
+    // Replace a frame that was never shown.
+    Canvas *replaced = _waiting;
+    if (replaced) _dropped++;
+
+    _waiting = reading;
+    reading = replaced;
+
+    pthread_cond_signal(&_frameReady);
+    pthread_mutex_unlock(&_mutex);
+  }
+
+  delete reading;
+
+  pthread_mutex_lock(&_mutex);
+  _ended = true;
+  pthread_cond_signal(&_frameReady);
+  pthread_mutex_unlock(&_mutex);
+}
+
+
+bool VideoStream::readFrameSize(int16_t *width, int16_t *height)
+{
+  if (_format == FormatRaw)
+  {
+    *width = _width;
+    *height = _height;
+    return true;
+  }
+
+  // "P6", width, height and maxval separated by whitespace or comments.
+  int values[3] = { 0, 0, 0 };
+  int c = readByte();
+
+  if (c != 'P' || readByte() != '6')
+  {
+    if (c >= 0) fprintf(stderr, "VideoStream: Can only handle P6 as PPM type.\n");
+    return false;
+  }
+
+  c = readByte();
+
+  for (int i = 0; i < 3; i++)
+  {
+    while (c == '#' || c == ' ' || c == '\t' || c == '\r' || c == '\n')
+    {
+      if (c == '#')
+      {
+        while (c != '\n' && c >= 0) c = readByte();
+      }
+
+      c = readByte();
+    }
+
+    if (c < '0' || c > '9') return false;
+
+    while (c >= '0' && c <= '9')
+    {
+      values[i] = values[i] * 10 + (c - '0');
+      if (values[i] > 4096) return false;
+
+      c = readByte();
+    }
+  }
+
+  // c is now the single whitespace before the pixels.
+  if (values[0] <= 0 || values[1] <= 0 || values[2] != 255)
+  {
+    fprintf(stderr, "VideoStream: Bad PPM header.\n");
+    return false;
+  }
+
+  *width = values[0];
+  *height = values[1];
+  return true;
+}
+
+
+bool VideoStream::readFrame(Canvas *canvas)
+{
+  for (int y = 0; y < canvas->height(); y++)
+  {
+    if (!readBytes((uint8_t *)canvas->row(y), canvas->width() * sizeof(Color)))
+      return false;
+  }
+
+  return true;
+}
+
+
+int VideoStream::readByte()
+{
+  if (_bufferPos == _bufferEnd && !fillBuffer()) return -1;
+
+  return _buffer[_bufferPos++];
+}
+
+
+bool VideoStream::readBytes(uint8_t *dst, size_t n)
+{
+  while (n > 0)
+  {
+    if (_bufferPos == _bufferEnd && !fillBuffer()) return false;
+
+    size_t count = _bufferEnd - _bufferPos;
+    if (count > n) count = n;
+
+    memcpy(dst, _buffer + _bufferPos, count);
+
+    _bufferPos += count;
+    dst += count;
+    n -= count;
+  }
+
+  return true;
+}
+
+
+bool VideoStream::fillBuffer()
+{
+  struct pollfd p;
+  p.fd = _fd;
+  p.events = POLLIN;
+
+  while (!_stopping)
+  {
+    const int ready = poll(&p, 1, PollTimeoutMs);
+
+    if (ready < 0 && errno != EINTR) return false;
+    if (ready <= 0) continue;
+
+    const ssize_t n = read(_fd, _buffer, sizeof(_buffer));
+
+    if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+    if (n <= 0) return false;
+
+    _bufferPos = 0;
+    _bufferEnd = n;
+    return true;
+  }
+
+  return false;
+}
+
+
+void VideoStream::convertFrame(const Canvas &canvas, RgbMatrix::Frame *frame)
+{
+  if (_fit == FitCrop ||
+      (canvas.width() == RgbMatrix::Width && canvas.height() == RgbMatrix::Height))
+  {
+    _matrix->convertFrame(canvas, frame,
+                          (RgbMatrix::Width - canvas.width()) / 2,
+                          (RgbMatrix::Height - canvas.height()) / 2);
+    return;
+  }
+
+  const Rect srcRect = { 0, 0, canvas.width(), canvas.height() };
+  Rect dstRect = { 0, 0, RgbMatrix::Width, RgbMatrix::Height };
+
+  if (_fit == FitContain)
+  {
+    // Black bars where the image doesn't reach.
+    dstRect = Resampler::fitRect(canvas.width(), canvas.height(),
+                                 RgbMatrix::Width, RgbMatrix::Height);
+    _scaled->clear();
+  }
+
+  _resampler.resample(canvas, srcRect, _scaled, dstRect);
+  _matrix->convertFrame(*_scaled, frame);
+}
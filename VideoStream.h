@@ -0,0 +1,136 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Play a stream of video frames read from a file descriptor (stdin, a FIFO,
+// a socket), e.g. piped from ffmpeg:
+//
+//   ffmpeg -i video.mp4 -f image2pipe -vcodec ppm - | sudo ./video-play
+//
+// The stream is either concatenated binary PPM (P6) images or raw 24 bit
+// RGB frames of a known size. A reader thread reads frames into one buffer
+// while the last complete frame waits in another, so reading never stalls
+// the display. Each frame is cropped or scaled to the matrix and shown
+// through a DoubleBuffer.
+//
+// When frames arrive faster than they are shown, the waiting frame is
+// replaced by the newer one (dropped), so a live source never builds up a
+// backlog. Without dropping, the reader waits instead, which suits playing
+// a file as fast as the frame rate allows.
+
+#ifndef RPI_VIDEOSTREAM_H
+#define RPI_VIDEOSTREAM_H
+
+#include "Canvas.h"
+#include "DoubleBuffer.h"
+#include "Resampler.h"
+#include "RgbMatrix.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+
+class VideoStream
+{
+public:
+
+  enum Format { FormatPpm, FormatRaw };
+
+  // How frames of a different size than the matrix are shown.
+  //   FitCrop    : centered, cropping or padding with black
+  //   FitScale   : stretched to the whole matrix
+  //   FitContain : scaled as large as fits, keeping the aspect ratio
+  enum Fit { FitCrop, FitScale, FitContain };
+
+
+  VideoStream(RgbMatrix *matrix);
+  ~VideoStream();
+
+  // Start reading frames from fd. Raw frames need their width and height.
+  // The stream doesn't close fd.
+  bool open(int fd, Format format, int16_t width = 0, int16_t height = 0);
+
+  // Stop reading and stop showing frames.
+  void close();
+
+  void setFit(Fit fit);
+
+  // Filter for scaling frames (FilterArea by default).
+  void setFilter(Resampler::Filter filter);
+
+  // Frames per second to show (0: as fast as they arrive).
+  void setFrameRate(float fps);
+
+  // Replace a waiting frame with a newer one rather than wait for it to be
+  // shown. On by default.
+  void setDropLate(bool dropLate);
+
+  // Wait for the next frame time and frame, and show it.
+  // Returns false at the end of the stream.
+  bool showNext();
+
+  inline uint32_t framesShown() const { return _shown; }
+  inline uint32_t framesDropped() const { return _dropped; }
+
+
+private:
+
+  VideoStream(const VideoStream &);
+  VideoStream &operator=(const VideoStream &);
+
+  static void *readerThread(void *stream);
+  void readFrames();
+
+  // Read the size of the next frame (the PPM header). Returns false at the
+  // end of the stream.
+  bool readFrameSize(int16_t *width, int16_t *height);
+
+  bool readFrame(Canvas *canvas);
+
+  // Buffered reads from _fd that give up when the stream is closed.
+  int readByte();
+  bool readBytes(uint8_t *dst, size_t n);
+  bool fillBuffer();
+
+  // Convert a frame into the bit planes of frame, cropped or scaled.
+  void convertFrame(const Canvas &canvas, RgbMatrix::Frame *frame);
+
+  RgbMatrix *const _matrix;
+
+  int _fd;
+  Format _format;
+  int16_t _width, _height;  // Size of raw frames
+  Fit _fit;
+  bool _dropLate;
+
+  pthread_t _thread;
+  bool _threadRunning;
+  pthread_mutex_t _mutex;
+  pthread_cond_t _frameReady;
+  pthread_cond_t _frameTaken;
+
+  // Read buffer of the reader thread.
+  uint8_t _buffer[65536];
+  size_t _bufferPos, _bufferEnd;
+
+  // Shared with the reader thread (under _mutex).
+  Canvas *_waiting;  // Complete frame waiting to be shown, or NULL
+  Canvas *_spare;    // Buffer the reader can read the next frame into
+  bool _ended;
+  volatile bool _stopping;
+  uint32_t _dropped;
+
+  Canvas *_showing;  // Last frame taken by showNext()
+  Canvas *_scaled;   // Matrix sized buffer for scaled frames
+  Resampler _resampler;
+
+  // Bit planes being shown and being converted into.
+  DoubleBuffer _buffers;
+
+  long _periodNs;  // 0: no frame rate
+  struct timespec _deadline;
+  uint32_t _shown;
+};
+
+#endif
@@ -3,6 +3,9 @@
 // that can be found in the LICENSE file.
 
 #include "DisplayUpdater.h"
+#include "GifAnimation.h"
+#include "IndexedCanvas.h"
+#include "Palette.h"
 #include "RgbMatrix.h"
 #include "RgbMatrixContainer.h"
 #include "Thread.h"
@@ -375,133 +378,29 @@ private:
 class RgbMatrixAnimatedGif : public RgbMatrixContainer
 {
 public:
-  RgbMatrixAnimatedGif(RgbMatrix *m) : RgbMatrixContainer(m) {}
-
-/*
-  // Simple GIF loader.
-  bool loadGif(const char *filename)
-  {
-    if (_image)
-    {
-      delete [] _image;
-      _image = NULL;
-    }
-
-    FILE *f = fopen(filename, "r");
-    if (f == NULL) return false;
-    char header_buf[256];
-    const char *line = ReadLine(f, header_buf, sizeof(header_buf));
-
-#define EXIT_WITH_MSG(m) { fprintf(stderr, "%s: %s |%s", filename, m, line); \
-     fclose(f); return false; }
-
-    if (sscanf(line, "P6 ") == EOF)
-      EXIT_WITH_MSG("Can only handle P6 as PPM type.");
-
-    line = ReadLine(f, header_buf, sizeof(header_buf));
-
-    if (!line || sscanf(line, "%d %d ", &width_, &height_) != 2)
-      EXIT_WITH_MSG("Width/height expected");
-
-    int value;
-    line = ReadLine(f, header_buf, sizeof(header_buf));
-
-    if (!line || sscanf(line, "%d ", &value) != 1 || value != 255)
-      EXIT_WITH_MSG("Only 255 for maxval allowed.");
-
-    const size_t pixel_count = width_ * height_;
-    _image = new Pixel [ pixel_count ];
-    assert(sizeof(Pixel) == 3);   // we make that assumption.
-
-    if (fread(_image, sizeof(Pixel), pixel_count, f) != pixel_count)
-    {
-      line = "";
-      EXIT_WITH_MSG("Not enough pixels read.");
-    }
-
-#undef EXIT_WITH_MSG
-
-    fclose(f);
-    fprintf(stderr, "Read image with %dx%d\n", width_, height_);
-    _depth = 0;
-    return true;
-  }
-*/
-
-
+  RgbMatrixAnimatedGif(RgbMatrix *m, GifAnimation *animation)
+    : RgbMatrixContainer(m), _animation(animation) {}
 
   void run()
   {
-    uint32_t count = 0;
+    // The frames were converted when the GIF was loaded, so each frame is
+    // only a pointer swap.
+    int loop = 0;
 
     while (!isDone())
     {
-      count++;
-
-      int color = (count >> 9) % 7; //512 steps for each color (256 up / 256 down)
-      int value = count & 0xFF;
-
-      if (count & 0x100) value = 255 - value; // pulse down
-
-      int r, g, b;
-
-      switch (color)
-      {
-        case 0: r = value; g = b = 0; break;
-        case 1: g = value; r = b = 0; break;
-        case 2: b = value; r = g = 0; break;
-        case 3: r = g = value; b = 0; break;
-        case 4: r = b = value; g = 0; break;
-        case 5: g = b = value; r = 0; break;
-        default: r = g = b = value; break;
-      }
-
-      for (int i=0; i < 32; i++)
+      for (int i = 0; i < _animation->frameCount() && !isDone(); i++)
       {
-        Color iColor;
-        iColor.red   = (((i+1) * 8) > r) ? r : 0;
-        iColor.green = (((i+1) * 8) > g) ? g : 0;
-        iColor.blue  = (((i+1) * 8) > b) ? b : 0;
-
-        _matrix->drawRect(0, i, 32, 1, iColor);
+        _animation->show(i);
+        usleep(_animation->delayMs(i) * 1000);
       }
 
-      usleep(2500);
+      if (_animation->loopCount() && ++loop > _animation->loopCount()) break;
     }
   }
 
-
 private:
-  struct Pixel {
-    uint8_t red;
-    uint8_t green;
-    uint8_t blue;
-  };
-
-  // Read line, skip comments.
-  char *readLine(FILE *f, char *buffer, size_t len)
-  {
-    char *result;
-    do 
-    {
-      result = fgets(buffer, len, f);
-    } while (result != NULL && result[0] == '#');
-
-    return result;
-  }
-
-  const Pixel &getPixel(int x, int y) 
-  {
-    static Pixel dummy;
-    if (x < 0 || x > width_ || y < 0 || y > height_) return dummy;
-    return _image[x + width_ * y];
-  }
-
-  int width_;
-  int height_;
-  int _depth;
-
-  Pixel *_image; //array of pixels...
+  GifAnimation *const _animation;
 
 };
 
@@ -520,6 +419,49 @@ public:
 };
 
 
+// Plasma: each pixel picks a color from a palette by the sum of a few sine
+// waves. The pattern is drawn once; cycling the palette animates it.
+class RgbMatrixPlasma : public RgbMatrixContainer
+{
+public:
+  RgbMatrixPlasma(RgbMatrix *m) : RgbMatrixContainer(m) {}
+
+  void run()
+  {
+    uint8_t sine[256];
+
+    for (int i = 0; i < 256; i++)
+    {
+      sine[i] = (uint8_t)(127.5 + 127.5 * sin(i * 2 * M_PI / 256));
+    }
+
+    IndexedCanvas plasma(RgbMatrix::Width, RgbMatrix::Height);
+
+    for (int y = 0; y < RgbMatrix::Height; y++)
+    {
+      for (int x = 0; x < RgbMatrix::Width; x++)
+      {
+        plasma.setPixel(x, y, (sine[(uint8_t)(x * 8)] +
+                               sine[(uint8_t)(y * 6)] +
+                               sine[(uint8_t)((x + y) * 4)] +
+                               sine[(uint8_t)(x * y / 4)]) >> 2);
+      }
+    }
+
+    Palette palette;
+    palette.setRainbow();
+
+    while (!isDone())
+    {
+      palette.rotate(1);
+      _matrix->drawIndexed(plasma, palette);
+
+      usleep(20000);
+    }
+  }
+};
+
+
 //-----------------------------------------------------------------------------
 // Display a menu and allow choosing different demos.
 
@@ -528,6 +470,9 @@ RgbMatrix *m = NULL;
 RgbMatrixContainer *display = NULL;
 RgbMatrixContainer *updater = NULL;
 
+// Animated GIF given on the command line, if any.
+GifAnimation *animation = NULL;
+
 
 void displayMenu()
 {
@@ -541,7 +486,9 @@ void displayMenu()
   printf("      |      (4) Pulse Pixels with a Gradient          |\n");
   printf("      |      (5) Display an Animated Line              |\n");
   printf("      |      (6) Draw a Color Wheel                    |\n");
-  printf("      |      (7) Quit                                  |\n");
+  printf("      |      (7) Play an Animated GIF                  |\n");
+  printf("      |      (8) Plasma                                |\n");
+  printf("      |      (9) Quit                                  |\n");
   printf("      |------------------------------------------------|\n");
   printf("                   Your Choice: ");
 }
@@ -561,6 +508,8 @@ void runDemo()
   display = NULL;
   updater = NULL;
 
+  if (animation) animation->hide();
+
   m->clearDisplay();
   m->updateDisplay();
 }
@@ -575,9 +524,20 @@ int main(int argc, char *argv[])
 
   m = new RgbMatrix(&io);
 
+  if (argc > 1)
+  {
+    animation = new GifAnimation(m);
+
+    if (!animation->load(argv[1]))
+    {
+      delete animation;
+      animation = NULL;
+    }
+  }
+
   char choice = '1';
 
-  while (choice != '7' && choice != 'q' && choice != 'Q')
+  while (choice != '9' && choice != 'q' && choice != 'Q')
   {
     displayMenu();
 
@@ -616,7 +576,6 @@ int main(int argc, char *argv[])
 
       case '5':
         display = new RgbMatrixAnimatedLine(m);
-        //display = new RgbMatrixAnimatedGif(m);
         updater = new DisplayUpdater(m);
         printf("\n\nRunning Demo #5.\n\n");
         runDemo();  
@@ -630,6 +589,29 @@ int main(int argc, char *argv[])
         break;
 
       case '7':
+        if (animation == NULL)
+        {
+          printf("\n\nStart the demo with a GIF file to play it:\n");
+          printf("  sudo ./demo animation.gif\n\n");
+          printf("Press <RETURN> to continue.\n");
+          getchar();
+          break;
+        }
+
+        display = new RgbMatrixAnimatedGif(m, animation);
+        updater = new DisplayUpdater(m);
+        printf("\n\nRunning Demo #7.\n\n");
+        runDemo();
+        break;
+
+      case '8':
+        display = new RgbMatrixPlasma(m);
+        updater = new DisplayUpdater(m);
+        printf("\n\nRunning Demo #8.\n\n");
+        runDemo();
+        break;
+
+      case '9':
       case 'q':
       case 'Q':
         printf("\n\nHave a nice day!\n\n");
@@ -644,6 +626,8 @@ int main(int argc, char *argv[])
   if (display) delete display;
   if (updater) delete updater;
 
+  delete animation;
+
   // Clear and refresh the display.
   m->clearDisplay();
   m->updateDisplay();
@@ -0,0 +1,156 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Convert GIF and PPM images into an animation file that animation-play
+// shows without any decoding on the Pi.
+//
+//   animation-convert [-d delayMs] [-s] -o output.rgbm input...
+//
+// Each GIF adds all of its frames with their own delays. Each PPM adds one
+// frame shown for delayMs (default 100). Images are centered on the matrix;
+// with -s, images larger than the matrix are scaled down to fit.
+//
+// Conversion doesn't need a panel, so content can be prepared on another
+// machine, as long as the library is built with the same constants.
+
+#include "AnimationWriter.h"
+#include "Canvas.h"
+#include "GifDecoder.h"
+#include "Resampler.h"
+#include "RgbMatrix.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static void usage(const char *program)
+{
+  fprintf(stderr, "usage: %s [-d delayMs] [-s] -o output.rgbm input.gif|input.ppm...\n",
+          program);
+}
+
+
+static bool endsWith(const char *s, const char *suffix)
+{
+  const size_t n = strlen(s);
+  const size_t m = strlen(suffix);
+
+  return n >= m && strcasecmp(s + n - m, suffix) == 0;
+}
+
+
+// Add an image centered on the matrix, or scaled down to fit it.
+static bool addImage(AnimationWriter &writer, const Canvas &image, int delayMs,
+                     bool fit)
+{
+  if (fit && (image.width() > RgbMatrix::Width ||
+              image.height() > RgbMatrix::Height))
+  {
+    // Kept between frames, so the frames of a GIF reuse its tables.
+    static Resampler resampler;
+
+    Canvas scaled(RgbMatrix::Width, RgbMatrix::Height);
+    const Rect all = { 0, 0, image.width(), image.height() };
+    const Rect rect = Resampler::fitRect(image.width(), image.height(),
+                                         RgbMatrix::Width, RgbMatrix::Height);
+
+    resampler.resample(image, all, &scaled, rect);
+
+    return writer.addFrame(scaled, delayMs);
+  }
+
+  const int16_t x = (RgbMatrix::Width - image.width()) / 2;
+  const int16_t y = (RgbMatrix::Height - image.height()) / 2;
+
+  return writer.addFrame(image, delayMs, x, y);
+}
+
+
+static bool addGif(AnimationWriter &writer, const char *filename, bool fit)
+{
+  GifDecoder gif;
+
+  if (!gif.open(filename)) return false;
+
+  while (gif.nextFrame())
+  {
+    if (!addImage(writer, gif.screen(), gif.delayMs(), fit)) return false;
+  }
+
+  return true;
+}
+
+
+static bool addPpm(AnimationWriter &writer, const char *filename, int delayMs,
+                   bool fit)
+{
+  Canvas *image = Canvas::loadPpm(filename);
+
+  if (image == NULL) return false;
+
+  const bool ok = addImage(writer, *image, delayMs, fit);
+
+  delete image;
+  return ok;
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char *output = NULL;
+  int delayMs = 100;
+  bool fit = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:so:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'd': delayMs = atoi(optarg); break;
+      case 's': fit = true; break;
+      case 'o': output = optarg; break;
+      default: usage(argv[0]); return 1;
+    }
+  }
+
+  if (output == NULL || optind == argc || delayMs <= 0)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  // Only used to convert frames, so no GPIO.
+  RgbMatrix matrix(NULL);
+  AnimationWriter writer(&matrix);
+
+  if (!writer.open(output)) return 1;
+
+  for (int i = optind; i < argc; i++)
+  {
+    const bool ok = endsWith(argv[i], ".gif")
+                    ? addGif(writer, argv[i], fit)
+                    : addPpm(writer, argv[i], delayMs, fit);
+    if (!ok)
+    {
+      writer.close();
+      unlink(output);
+      return 1;
+    }
+  }
+
+  const int frameCount = writer.frameCount();
+
+  if (!writer.close())
+  {
+    fprintf(stderr, "%s: Write failed.\n", output);
+    unlink(output);
+    return 1;
+  }
+
+  printf("Wrote %d frames to %s\n", frameCount, output);
+
+  return 0;
+}
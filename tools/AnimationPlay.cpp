@@ -0,0 +1,112 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Play an animation file made by animation-convert.
+//
+//   sudo animation-play [-l loops] animation.rgbm
+//
+// The file is memory mapped and the frames are scanned out straight from it,
+// so the only work besides refreshing the display is sleeping until the next
+// frame. Plays forever unless a number of loops is given; Ctrl-C stops.
+
+#include "AnimationFile.h"
+#include "DisplayUpdater.h"
+#include "GpioProxy.h"
+#include "RgbMatrix.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void onSignal(int)
+{
+  interrupted = 1;
+}
+
+
+// Sleep until deadline plus delayMs, and move the deadline there. Sleeping
+// until an absolute time keeps long animations from drifting.
+static void sleepUntilNext(struct timespec *deadline, int delayMs)
+{
+  deadline->tv_sec += delayMs / 1000;
+  deadline->tv_nsec += (delayMs % 1000) * 1000000L;
+
+  if (deadline->tv_nsec >= 1000000000L)
+  {
+    deadline->tv_sec++;
+    deadline->tv_nsec -= 1000000000L;
+  }
+
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline, NULL) != 0 &&
+         !interrupted)
+  {
+    ;
+  }
+}
+
+
+int main(int argc, char *argv[])
+{
+  int loops = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "l:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'l': loops = atoi(optarg); break;
+      default: optind = argc; break;
+    }
+  }
+
+  if (optind != argc - 1)
+  {
+    fprintf(stderr, "usage: %s [-l loops] animation.rgbm\n", argv[0]);
+    return 1;
+  }
+
+  GpioProxy io;
+
+  if (!io.initialize())
+    return 1;
+
+  RgbMatrix matrix(&io);
+  AnimationFile animation(&matrix);
+
+  if (!animation.open(argv[optind]) || animation.frameCount() == 0)
+    return 1;
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  DisplayUpdater *updater = new DisplayUpdater(&matrix);
+  updater->start(10);
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+  for (int loop = 0; !interrupted && (loops == 0 || loop < loops); loop++)
+  {
+    for (int i = 0; i < animation.frameCount() && !interrupted; i++)
+    {
+      animation.show(i);
+      sleepUntilNext(&deadline, animation.delayMs(i));
+    }
+  }
+
+  // Stop refreshing before the file is unmapped.
+  delete updater;
+  animation.close();
+
+  // Clear and refresh the display.
+  matrix.clearDisplay();
+  matrix.updateDisplay();
+
+  return 0;
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Show what renderers in other processes publish to a shared framebuffer.
+//
+//   sudo framebuffer-daemon [-n name] [-p pollMs] [-c capture.ppm [-i ms]]
+//
+// Creates the framebuffer (default /rgbmatrix, the size of the matrix) and
+// checks it for new frames every pollMs (default 5). Renderers attach to it
+// with SharedFrameBuffer::attach() and don't need to run as root.
+//
+// With -c, what the matrix shows is saved to capture.ppm every ms
+// (default 1000), e.g. for checking on the sign remotely.
+
+#include "DisplayUpdater.h"
+#include "DoubleBuffer.h"
+#include "FrameCapture.h"
+#include "GpioProxy.h"
+#include "RgbMatrix.h"
+#include "SharedFrameBuffer.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void onSignal(int)
+{
+  interrupted = 1;
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char *name = SharedFrameBuffer::DefaultName;
+  int pollMs = 5;
+  const char *captureFile = NULL;
+  int captureMs = 1000;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:p:c:i:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': name = optarg; break;
+      case 'p': pollMs = atoi(optarg); break;
+      case 'c': captureFile = optarg; break;
+      case 'i': captureMs = atoi(optarg); break;
+      default: optind = -1; break;
+    }
+
+    if (optind < 0) break;
+  }
+
+  if (optind != argc || pollMs <= 0 || captureMs <= 0)
+  {
+    fprintf(stderr, "usage: %s [-n name] [-p pollMs] [-c capture.ppm [-i ms]]\n",
+            argv[0]);
+    return 1;
+  }
+
+  GpioProxy io;
+
+  if (!io.initialize())
+    return 1;
+
+  RgbMatrix matrix(&io);
+  SharedFrameBuffer framebuffer;
+
+  if (!framebuffer.create(name, RgbMatrix::Width, RgbMatrix::Height))
+    return 1;
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  Canvas canvas(RgbMatrix::Width, RgbMatrix::Height);
+
+  DoubleBuffer buffers(&matrix);
+
+  DisplayUpdater *updater = new DisplayUpdater(&matrix);
+  updater->start(10);
+
+  FrameCapture capture(&matrix);
+
+  if (captureFile && !capture.start(captureFile, captureMs))
+    interrupted = 1;
+
+  while (!interrupted)
+  {
+    if (framebuffer.read(&canvas))
+    {
+      buffers.show(canvas);
+    }
+    else
+    {
+      usleep(pollMs * 1000);
+    }
+  }
+
+  // Stop capturing and refreshing, and show what is drawn again.
+  capture.stop();
+  delete updater;
+  buffers.release();
+
+  // Clear and refresh the display.
+  matrix.clearDisplay();
+  matrix.updateDisplay();
+
+  return 0;
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Show frames sent over the network by frame-send (or any FrameSender).
+//
+//   sudo frame-receive [-a address] [-s seconds] [-x]
+//
+// Options:
+//   -a address : udp:host:port or unix:/path (default udp:0.0.0.0:7777)
+//   -s seconds : print statistics this often (default 10)
+//   -x         : don't drive a panel; only receive and print statistics,
+//                e.g. to test a sender on localhost without a Pi
+
+#include "DisplayUpdater.h"
+#include "DoubleBuffer.h"
+#include "FrameReceiver.h"
+#include "GpioProxy.h"
+#include "RgbMatrix.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void onSignal(int)
+{
+  interrupted = 1;
+}
+
+
+static void printStats(const FrameReceiver::Stats &stats)
+{
+  fprintf(stderr,
+          "frames %u, dropped %u | packets %u, bad %u, late %u, per call %.1f"
+          " | latency avg %.2f ms, max %.2f ms\n",
+          stats.frames, stats.framesDropped,
+          stats.packets, stats.packetsBad, stats.packetsLate,
+          stats.receiveCalls ? (double)stats.packets / stats.receiveCalls : 0.0,
+          stats.frames ? stats.latencyTotalUs / 1000.0 / stats.frames : 0.0,
+          stats.latencyMaxUs / 1000.0);
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char *address = "udp:0.0.0.0:7777";
+  int statsSeconds = 10;
+  bool noPanel = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "a:s:x")) != -1)
+  {
+    switch (opt)
+    {
+      case 'a': address = optarg; break;
+      case 's': statsSeconds = atoi(optarg); break;
+      case 'x': noPanel = true; break;
+      default: optind = -1; break;
+    }
+
+    if (optind < 0) break;
+  }
+
+  if (optind != argc || statsSeconds <= 0)
+  {
+    fprintf(stderr, "usage: %s [-a address] [-s seconds] [-x]\n", argv[0]);
+    return 1;
+  }
+
+  GpioProxy io;
+
+  if (!noPanel && !io.initialize())
+    return 1;
+
+  RgbMatrix matrix(noPanel ? NULL : &io);
+  FrameReceiver receiver(RgbMatrix::Width, RgbMatrix::Height);
+
+  if (!receiver.open(address))
+    return 1;
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  DoubleBuffer buffers(&matrix);
+
+  DisplayUpdater *updater = NULL;
+
+  if (!noPanel)
+  {
+    updater = new DisplayUpdater(&matrix);
+    updater->start(10);
+  }
+
+  time_t nextStats = time(NULL) + statsSeconds;
+
+  while (!interrupted)
+  {
+    // Only the last frame completed by a batch of packets is shown.
+    if (receiver.receive(100))
+    {
+      buffers.show(receiver.frame());
+    }
+
+    if (time(NULL) >= nextStats)
+    {
+      printStats(receiver.stats());
+      receiver.resetStats();
+      nextStats += statsSeconds;
+    }
+  }
+
+  printStats(receiver.stats());
+
+  // Stop refreshing and show what is drawn again.
+  delete updater;
+  buffers.release();
+
+  // Clear and refresh the display.
+  matrix.clearDisplay();
+  matrix.updateDisplay();
+
+  return 0;
+}
@@ -0,0 +1,271 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Send frames to frame-receive over the network.
+//
+//   frame-send [-a address] [-f fps] [-n frames] [-d] [-u] [image...]
+//
+// Sends the frames of the given GIF and PPM images in a loop, or an animated
+// test pattern if there are none.
+//
+// Options:
+//   -a address : udp:host:port or unix:/path (default udp:127.0.0.1:7777)
+//   -f fps     : frames per second (default 30)
+//   -n frames  : stop after this many frames (default: run until Ctrl-C)
+//   -d         : send only the rectangle that changed, with a key frame
+//                every second
+//   -u         : don't run-length encode
+//
+// To test on one machine without a panel:
+//
+//   ./frame-receive -x -s 1 &
+//   ./frame-send -d -n 300
+
+#include "Canvas.h"
+#include "FrameSender.h"
+#include "GifDecoder.h"
+#include "RgbMatrix.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void onSignal(int)
+{
+  interrupted = 1;
+}
+
+
+static bool endsWith(const char *s, const char *suffix)
+{
+  const size_t n = strlen(s);
+  const size_t m = strlen(suffix);
+
+  return n >= m && strcasecmp(s + n - m, suffix) == 0;
+}
+
+
+// Copy an image onto a matrix sized canvas, centered.
+static Canvas *centered(const Canvas &image)
+{
+  Canvas *canvas = new Canvas(RgbMatrix::Width, RgbMatrix::Height);
+
+  const int dx = (RgbMatrix::Width - image.width()) / 2;
+  const int dy = (RgbMatrix::Height - image.height()) / 2;
+
+  for (int y = 0; y < RgbMatrix::Height; y++)
+  {
+    for (int x = 0; x < RgbMatrix::Width; x++)
+    {
+      const int sx = x - dx, sy = y - dy;
+
+      if (sx >= 0 && sy >= 0 && sx < image.width() && sy < image.height())
+      {
+        canvas->row(y)[x] = image.getPixel(sx, sy);
+      }
+    }
+  }
+
+  return canvas;
+}
+
+
+static bool loadImage(const char *filename, std::vector<Canvas *> &frames)
+{
+  if (endsWith(filename, ".gif"))
+  {
+    GifDecoder gif;
+
+    if (!gif.open(filename)) return false;
+
+    while (gif.nextFrame())
+    {
+      frames.push_back(centered(gif.screen()));
+    }
+
+    return true;
+  }
+
+  Canvas *image = Canvas::loadPpm(filename);
+
+  if (image == NULL) return false;
+
+  frames.push_back(centered(*image));
+  delete image;
+
+  return true;
+}
+
+
+// A gradient background with a bar moving across it.
+static void drawTestPattern(Canvas *canvas, uint32_t frame)
+{
+  const int bar = frame % RgbMatrix::Width;
+
+  for (int y = 0; y < RgbMatrix::Height; y++)
+  {
+    for (int x = 0; x < RgbMatrix::Width; x++)
+    {
+      Color c;
+      c.red = x * 255 / (RgbMatrix::Width - 1);
+      c.green = y * 255 / (RgbMatrix::Height - 1);
+      c.blue = 64;
+
+      if (x == bar) c.red = c.green = c.blue = 255;
+
+      canvas->row(y)[x] = c;
+    }
+  }
+}
+
+
+// Bounding box of the pixels that differ between two canvases.
+static bool changedRect(const Canvas &a, const Canvas &b, Rect *rect)
+{
+  int x0 = a.width(), y0 = a.height(), x1 = -1, y1 = -1;
+
+  for (int y = 0; y < a.height(); y++)
+  {
+    for (int x = 0; x < a.width(); x++)
+    {
+      const Color &p = a.row(y)[x];
+      const Color &q = b.row(y)[x];
+
+      if (p.red != q.red || p.green != q.green || p.blue != q.blue)
+      {
+        if (x < x0) x0 = x;
+        if (x > x1) x1 = x;
+        if (y < y0) y0 = y;
+        if (y > y1) y1 = y;
+      }
+    }
+  }
+
+  if (x1 < 0) return false;
+
+  rect->x = x0;
+  rect->y = y0;
+  rect->w = x1 - x0 + 1;
+  rect->h = y1 - y0 + 1;
+
+  return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+  const char *address = "udp:127.0.0.1:7777";
+  float fps = 30;
+  long frameLimit = 0;
+  bool delta = false;
+  bool compress = true;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "a:f:n:du")) != -1)
+  {
+    switch (opt)
+    {
+      case 'a': address = optarg; break;
+      case 'f': fps = atof(optarg); break;
+      case 'n': frameLimit = atol(optarg); break;
+      case 'd': delta = true; break;
+      case 'u': compress = false; break;
+      default: fps = 0; break;
+    }
+  }
+
+  if (fps <= 0)
+  {
+    fprintf(stderr, "usage: %s [-a address] [-f fps] [-n frames] [-d] [-u] [image...]\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::vector<Canvas *> images;
+
+  for (int i = optind; i < argc; i++)
+  {
+    if (!loadImage(argv[i], images)) return 1;
+  }
+
+  FrameSender sender;
+
+  if (!sender.open(address))
+    return 1;
+
+  sender.setCompress(compress);
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  Canvas pattern(RgbMatrix::Width, RgbMatrix::Height);
+  Canvas previous(RgbMatrix::Width, RgbMatrix::Height);
+
+  const long periodNs = (long)(1000000000.0 / fps);
+  const uint32_t keyInterval = (fps < 1) ? 1 : (uint32_t)fps;
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+  for (uint32_t frame = 0; !interrupted && (frameLimit == 0 || frame < frameLimit); frame++)
+  {
+    const Canvas *canvas = &pattern;
+
+    if (images.empty())
+    {
+      drawTestPattern(&pattern, frame);
+    }
+    else
+    {
+      canvas = images[frame % images.size()];
+    }
+
+    Rect rect;
+
+    if (!delta || frame % keyInterval == 0)
+    {
+      sender.sendFrame(*canvas);
+    }
+    else if (changedRect(*canvas, previous, &rect))
+    {
+      sender.sendDelta(*canvas, &rect, 1);
+    }
+    else
+    {
+      sender.sendDelta(*canvas, NULL, 0);
+    }
+
+    for (int y = 0; y < RgbMatrix::Height; y++)
+    {
+      memcpy(previous.row(y), canvas->row(y), RgbMatrix::Width * sizeof(Color));
+    }
+
+    deadline.tv_nsec += periodNs;
+
+    while (deadline.tv_nsec >= 1000000000L)
+    {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+  }
+
+  printf("Sent %u frames to %s\n", sender.frameNumber(), address);
+
+  for (size_t i = 0; i < images.size(); i++)
+  {
+    delete images[i];
+  }
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2013 Matt Hill
+// Use of this source code is governed by The MIT License
+// that can be found in the LICENSE file.
+//
+// Play video frames piped to stdin.
+//
+//   ffmpeg -re -i video.mp4 -f image2pipe -vcodec ppm - | sudo video-play
+//   ffmpeg -i video.mp4 -s 32x32 -f rawvideo -pix_fmt rgb24 - |
+//     sudo video-play -r 32x32 -f 25 -k
+//
+// Options:
+//   -r WxH : raw RGB frames of this size instead of PPM images
+//   -f fps : show at most this many frames per second
+//   -s     : stretch frames to the matrix instead of cropping them
+//   -c     : scale frames to fit the matrix, keeping their aspect ratio
+//   -k     : keep every frame (the pipe waits) instead of dropping late ones
+//   -d     : dither colors: o (ordered), e (error diffusion) or t (temporal)
+
+#include "DisplayUpdater.h"
+#include "GpioProxy.h"
+#include "RgbMatrix.h"
+#include "VideoStream.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static void onSignal(int)
+{
+  // Make showNext() return false once the reader stops.
+  close(STDIN_FILENO);
+}
+
+
+int main(int argc, char *argv[])
+{
+  VideoStream::Format format = VideoStream::FormatPpm;
+  VideoStream::Fit fit = VideoStream::FitCrop;
+  int width = 0, height = 0;
+  float fps = 0;
+  bool dropLate = true;
+  RgbMatrix::Dither dither = RgbMatrix::DitherNone;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "r:f:sckd:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'r':
+        if (sscanf(optarg, "%dx%d", &width, &height) != 2) optind = -1;
+        format = VideoStream::FormatRaw;
+        break;
+
+      case 'f': fps = atof(optarg); break;
+      case 's': fit = VideoStream::FitScale; break;
+      case 'c': fit = VideoStream::FitContain; break;
+      case 'k': dropLate = false; break;
+
+      case 'd':
+        if (strcmp(optarg, "o") == 0) dither = RgbMatrix::DitherOrdered;
+        else if (strcmp(optarg, "e") == 0) dither = RgbMatrix::DitherDiffusion;
+        else if (strcmp(optarg, "t") == 0) dither = RgbMatrix::DitherTemporal;
+        else optind = -1;
+        break;
+
+      default: optind = -1; break;
+    }
+
+    if (optind < 0) break;
+  }
+
+  if (optind != argc)
+  {
+    fprintf(stderr, "usage: %s [-r WxH] [-f fps] [-s|-c] [-k] [-d o|e|t] < frames\n", argv[0]);
+    return 1;
+  }
+
+  GpioProxy io;
+
+  if (!io.initialize())
+    return 1;
+
+  RgbMatrix matrix(&io);
+  matrix.setDither(dither);
+
+  VideoStream *stream = new VideoStream(&matrix);
+  stream->setFit(fit);
+  stream->setFrameRate(fps);
+  stream->setDropLate(dropLate);
+
+  if (!stream->open(STDIN_FILENO, format, width, height))
+    return 1;
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  DisplayUpdater *updater = new DisplayUpdater(&matrix);
+  updater->start(10);
+
+  while (stream->showNext())
+  {
+    ;
+  }
+
+  fprintf(stderr, "%u frames shown, %u dropped\n",
+          stream->framesShown(), stream->framesDropped());
+
+  // Stop refreshing before the frames are freed.
+  delete updater;
+  delete stream;
+
+  // Clear and refresh the display.
+  matrix.clearDisplay();
+  matrix.updateDisplay();
+
+  return 0;
+}